@@ -75,6 +75,7 @@
 
 #include <algorithm>
 #include <limits>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -84,13 +85,39 @@
 
 #include "csutil.hxx"
 
+// Affixes found by the last prefix_check() and suffix_check() (and used by
+// compound_check()). They are kept per thread, so words can be checked on
+// several threads at once, see SuggestMgr::suggest().
+struct affix_check_state {
+  const char* pfxappnd;  // previous prefix for counting syllables of the prefix
+  const char* sfxappnd;  // previous suffix for counting syllables of the suffix
+  int sfxextra;          // modifier for syllable count of sfxappnd
+  FLAG sfxflag;
+  SfxEntry* sfx;
+  PfxEntry* pfx;
+};
+
+static thread_local affix_check_state last_affix;
+
 AffixMgr::AffixMgr(const char* affpath,
                    const std::vector<HashMgr*>& ptr,
                    const char* key)
+  : AffixMgr(ptr) {
+
+  // load affix data from aff file
+  if (parse_file(affpath, key)) {
+    HUNSPELL_WARNING(stderr, "Failure loading aff file %s\n", affpath);
+  }
+
+  if (cpdmin == -1)
+    cpdmin = MINCPDLEN;
+}
+
+AffixMgr::AffixMgr(const std::vector<HashMgr*>& ptr)
   : alldic(ptr)
   , pHMgr(ptr[0]) {
 
-  // register hash manager and load affix data from aff file
+  // register hash manager
   csconv = NULL;
   utf8 = 0;
   complexprefixes = 0;
@@ -128,9 +155,6 @@ AffixMgr::AffixMgr(const char* affpath,
   cpdwordmax = -1;        // default: unlimited wordcount in compound words
   cpdmin = -1;            // undefined
   cpdmaxsyllable = 0;     // default: unlimited syllablecount in compound words
-  pfxappnd = NULL;  // previous prefix for counting syllables of the prefix BUG
-  sfxappnd = NULL;  // previous suffix for counting syllables of the suffix BUG
-  sfxextra = 0;     // modifier for syllable count of sfxappnd BUG
   checknum = 0;               // checking numbers, and word with numbers
   havecontclass = 0;  // flags of possible continuing classes (double affix)
   // LEMMA_PRESENT: not put root into the morphological output. Lemma presents
@@ -153,9 +177,6 @@ AffixMgr::AffixMgr(const char* affpath,
   substandard = FLAG_NULL;
   fullstrip = 0;
 
-  sfx = NULL;
-  pfx = NULL;
-
   for (int i = 0; i < SETSIZE; i++) {
     pStart[i] = NULL;
     sStart[i] = NULL;
@@ -166,13 +187,6 @@ AffixMgr::AffixMgr(const char* affpath,
   for (int j = 0; j < CONTSIZE; j++) {
     contclasses[j] = 0;
   }
-
-  if (parse_file(affpath, key)) {
-    HUNSPELL_WARNING(stderr, "Failure loading aff file %s\n", affpath);
-  }
-
-  if (cpdmin == -1)
-    cpdmin = MINCPDLEN;
 }
 
 AffixMgr::~AffixMgr() {
@@ -226,7 +240,9 @@ AffixMgr::~AffixMgr() {
   pHMgr = NULL;
   cpdmin = 0;
   cpdmaxsyllable = 0;
-  free_utf_tbl();
+  // utf8 is set only together with initialize_utf_tbl()
+  if (utf8)
+    free_utf_tbl();
   checknum = 0;
 #ifdef MOZILLA_CLIENT
   delete[] csconv;
@@ -241,6 +257,468 @@ void AffixMgr::finishFileMgr(FileMgr* afflst) {
   process_sfx_tree_to_list();
 }
 
+// affix entries are numbered from 1 in the order of pStart (sStart) lists,
+// which hold all of them, links between them are stored as these numbers
+template <class Entry>
+static void save_affix_entries(SnapshotWriter& out,
+                               Entry* const* start,
+                               Entry* const* flag) {
+  std::vector<Entry*> entries;
+  std::map<const Entry*, uint32_t> numbers;
+  numbers[NULL] = 0;
+  for (int i = 0; i < SETSIZE; i++) {
+    for (Entry* ep = start[i]; ep; ep = ep->getNext()) {
+      entries.push_back(ep);
+      numbers[ep] = (uint32_t)entries.size();
+    }
+  }
+  out.put_value((uint32_t)entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    Entry* ep = entries[i];
+    out.put_string(ep->appnd);
+    out.put_string(ep->strip);
+    out.put_value(ep->numconds);
+    // aliased flags and descriptions are restored as own copies
+    out.put_value((char)(ep->opts & ~(aeALIASF | aeALIASM)));
+    out.put_value(ep->aflag);
+    if (ep->opts & aeLONGCOND) {
+      out.put_string(std::string(ep->c.l.conds1, MAXCONDLEN_1));
+      out.put_string(ep->c.l.conds2);
+    } else {
+      out.put_string(std::string(
+          ep->c.conds, std::find(ep->c.conds, ep->c.conds + MAXCONDLEN, '\0')));
+    }
+    out.put_value((char)(ep->morphcode != NULL));
+    if (ep->morphcode)
+      out.put_string(ep->morphcode);
+    out.put_value((char)(ep->contclass != NULL));
+    out.put_value(ep->contclasslen);
+    if (ep->contclass)
+      out.put_bytes(ep->contclass, ep->contclasslen * sizeof(unsigned short));
+    out.put_value(numbers[ep->getNext()]);
+    out.put_value(numbers[ep->getNextEQ()]);
+    out.put_value(numbers[ep->getNextNE()]);
+    out.put_value(numbers[ep->getFlgNxt()]);
+  }
+  for (int i = 0; i < SETSIZE; i++) {
+    out.put_value(numbers[start[i]]);
+    out.put_value(numbers[flag[i]]);
+  }
+}
+
+static void init_affix_entry(PfxEntry*) {}
+
+static void init_affix_entry(SfxEntry* ep) {
+  ep->initReverseWord();
+}
+
+// entries are created in entries, start and flag are set only if all of them
+// are restored
+template <class Entry>
+static bool load_affix_entries(SnapshotReader& in,
+                               AffixMgr* mgr,
+                               std::vector<Entry*>& entries,
+                               Entry** start,
+                               Entry** flag) {
+  uint32_t count;
+  if (!in.get_value(count))
+    return false;
+  std::vector<uint32_t> links;
+  for (uint32_t i = 0; i < count; i++) {
+    Entry* ep = new Entry(mgr);
+    entries.push_back(ep);
+    char opts, has_morph, has_cont;
+    std::string conds, conds2;
+    if (!in.get_string(ep->appnd) || !in.get_string(ep->strip) ||
+        !in.get_value(ep->numconds) || !in.get_value(opts) ||
+        !in.get_value(ep->aflag) || !in.get_string(conds))
+      return false;
+    if (opts & aeLONGCOND) {
+      if (conds.size() != MAXCONDLEN_1 || !in.get_string(conds2))
+        return false;
+      memcpy(ep->c.l.conds1, conds.data(), MAXCONDLEN_1);
+      ep->c.l.conds2 = mystrdup(conds2.c_str());
+      if (!ep->c.l.conds2)
+        return false;
+    } else {
+      if (conds.size() > MAXCONDLEN)
+        return false;
+      memset(ep->c.conds, 0, MAXCONDLEN);
+      memcpy(ep->c.conds, conds.data(), conds.size());
+    }
+    // conds2 is owned from now on
+    ep->opts = opts & ~(aeALIASF | aeALIASM);
+    if (!in.get_value(has_morph))
+      return false;
+    if (has_morph) {
+      std::string morph;
+      if (!in.get_string(morph))
+        return false;
+      ep->morphcode = mystrdup(morph.c_str());
+      if (!ep->morphcode)
+        return false;
+    }
+    if (!in.get_value(has_cont) || !in.get_value(ep->contclasslen) ||
+        ep->contclasslen < 0)
+      return false;
+    if (has_cont) {
+      size_t size = ep->contclasslen * sizeof(unsigned short);
+      ep->contclass = (unsigned short*)malloc(size ? size : 1);
+      if (!ep->contclass || !in.get_bytes(ep->contclass, size))
+        return false;
+    }
+    for (int j = 0; j < 4; j++) {
+      uint32_t link;
+      if (!in.get_value(link) || link > count)
+        return false;
+      links.push_back(link);
+    }
+    init_affix_entry(ep);
+  }
+  std::vector<uint32_t> heads(2 * SETSIZE);
+  for (int i = 0; i < 2 * SETSIZE; i++) {
+    if (!in.get_value(heads[i]) || heads[i] > count)
+      return false;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    Entry* ep = entries[i];
+    ep->setNext(links[i * 4] ? entries[links[i * 4] - 1] : NULL);
+    ep->setNextEQ(links[i * 4 + 1] ? entries[links[i * 4 + 1] - 1] : NULL);
+    ep->setNextNE(links[i * 4 + 2] ? entries[links[i * 4 + 2] - 1] : NULL);
+    ep->setFlgNxt(links[i * 4 + 3] ? entries[links[i * 4 + 3] - 1] : NULL);
+  }
+  for (int i = 0; i < SETSIZE; i++) {
+    start[i] = heads[i * 2] ? entries[heads[i * 2] - 1] : NULL;
+    flag[i] = heads[i * 2 + 1] ? entries[heads[i * 2 + 1] - 1] : NULL;
+  }
+  return true;
+}
+
+static void save_replentries(SnapshotWriter& out,
+                             const replentry* const* entries,
+                             int count) {
+  out.put_value(count);
+  for (int i = 0; i < count; i++) {
+    out.put_string(entries[i]->pattern);
+    for (int j = 0; j < 4; j++)
+      out.put_string(entries[i]->outstrings[j]);
+  }
+}
+
+static bool load_replentry(SnapshotReader& in, replentry& entry) {
+  if (!in.get_string(entry.pattern))
+    return false;
+  for (int j = 0; j < 4; j++) {
+    if (!in.get_string(entry.outstrings[j]))
+      return false;
+  }
+  return true;
+}
+
+static void save_convtable(SnapshotWriter& out, RepList* table) {
+  out.put_value((char)(table != NULL));
+  if (!table)
+    return;
+  std::vector<const replentry*> entries;
+  for (int i = 0; i < table->count(); i++)
+    entries.push_back(table->item(i));
+  save_replentries(out, entries.empty() ? NULL : &entries[0],
+                   (int)entries.size());
+}
+
+static bool load_convtable(SnapshotReader& in, RepList** table) {
+  char present;
+  int count;
+  if (!in.get_value(present))
+    return false;
+  if (!present)
+    return true;
+  if (!in.get_value(count))
+    return false;
+  std::vector<replentry> entries;
+  for (int i = 0; i < count; i++) {
+    entries.push_back(replentry());
+    if (!load_replentry(in, entries.back()))
+      return false;
+  }
+  *table = new RepList((int)entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    if ((*table)->append(entries[i]))
+      return false;
+  }
+  return true;
+}
+
+static void save_strings(SnapshotWriter& out,
+                         const std::vector<std::string>& strings) {
+  out.put_value((uint64_t)strings.size());
+  for (size_t i = 0; i < strings.size(); i++)
+    out.put_string(strings[i]);
+}
+
+static bool load_strings(SnapshotReader& in,
+                         std::vector<std::string>& strings) {
+  uint64_t count;
+  if (!in.get_value(count))
+    return false;
+  strings.clear();
+  for (uint64_t i = 0; i < count; i++) {
+    std::string s;
+    if (!in.get_string(s))
+      return false;
+    strings.push_back(s);
+  }
+  return true;
+}
+
+// snapshot holds the state parse_file() leaves, affix entries with their
+// order links, then settings and tables
+void AffixMgr::save_snapshot(const HashMgr* dic) const {
+  std::vector<char> config;
+  SnapshotWriter out(config);
+  save_affix_entries(out, pStart, pFlag);
+  save_affix_entries(out, sStart, sFlag);
+  out.put_string(keystring);
+  out.put_string(trystring);
+  out.put_string(encoding);
+  out.put_value(utf8);
+  out.put_value(complexprefixes);
+  out.put_value(compoundflag);
+  out.put_value(compoundbegin);
+  out.put_value(compoundmiddle);
+  out.put_value(compoundend);
+  out.put_value(compoundroot);
+  out.put_value(compoundforbidflag);
+  out.put_value(compoundpermitflag);
+  out.put_value(compoundmoresuffixes);
+  out.put_value(checkcompounddup);
+  out.put_value(checkcompoundrep);
+  out.put_value(checkcompoundcase);
+  out.put_value(checkcompoundtriple);
+  out.put_value(simplifiedtriple);
+  out.put_value(forbiddenword);
+  out.put_value(nosuggest);
+  out.put_value(nongramsuggest);
+  out.put_value(needaffix);
+  out.put_value(cpdmin);
+  out.put_value(parsedrep);
+  std::vector<const replentry*> reps;
+  for (size_t i = 0; i < reptable.size(); i++)
+    reps.push_back(&reptable[i]);
+  save_replentries(out, reps.empty() ? NULL : &reps[0], (int)reps.size());
+  save_convtable(out, iconvtable);
+  save_convtable(out, oconvtable);
+  out.put_value(parsedmaptable);
+  out.put_value((uint64_t)maptable.size());
+  for (size_t i = 0; i < maptable.size(); i++)
+    save_strings(out, maptable[i]);
+  out.put_value(parsedbreaktable);
+  save_strings(out, breaktable);
+  out.put_value(parsedcheckcpd);
+  out.put_value((uint64_t)checkcpdtable.size());
+  for (size_t i = 0; i < checkcpdtable.size(); i++) {
+    out.put_string(checkcpdtable[i].pattern);
+    out.put_string(checkcpdtable[i].pattern2);
+    out.put_string(checkcpdtable[i].pattern3);
+    out.put_value(checkcpdtable[i].cond);
+    out.put_value(checkcpdtable[i].cond2);
+  }
+  out.put_value(simplifiedcpd);
+  out.put_value(parseddefcpd);
+  out.put_value((uint64_t)defcpdtable.size());
+  for (size_t i = 0; i < defcpdtable.size(); i++)
+    out.put_vector(defcpdtable[i]);
+  // phonetic hash is rebuilt from the rules
+  out.put_value((char)(phone != NULL));
+  if (phone) {
+    out.put_value(phone->utf8);
+    save_strings(out, phone->rules);
+  }
+  out.put_value(maxngramsugs);
+  out.put_value(maxcpdsugs);
+  out.put_value(maxdiff);
+  out.put_value(onlymaxdiff);
+  out.put_value(nosplitsugs);
+  out.put_value(sugswithdots);
+  out.put_value(cpdwordmax);
+  out.put_value(cpdmaxsyllable);
+  out.put_string(cpdvowels);
+  out.put_vector(cpdvowels_utf16);
+  out.put_string(cpdsyllablenum);
+  out.put_value(checknum);
+  out.put_string(wordchars);
+  out.put_vector(wordchars_utf16);
+  out.put_string(ignorechars);
+  out.put_vector(ignorechars_utf16);
+  out.put_string(version);
+  out.put_string(lang);
+  out.put_value(langnum);
+  out.put_value(lemma_present);
+  out.put_value(circumfix);
+  out.put_value(onlyincompound);
+  out.put_value(keepcase);
+  out.put_value(forceucase);
+  out.put_value(warn);
+  out.put_value(forbidwarn);
+  out.put_value(substandard);
+  out.put_value(checksharps);
+  out.put_value(fullstrip);
+  out.put_value(havecontclass);
+  out.put_bytes(contclasses, sizeof(contclasses));
+  dic->save_snapshot(config);
+}
+
+bool AffixMgr::load_snapshot() {
+  size_t size;
+  const char* config = pHMgr->get_affix_snapshot(size);
+  if (!config)
+    return false;
+  SnapshotReader in(config, size);
+  std::vector<PfxEntry*> prefixes;
+  std::vector<SfxEntry*> suffixes;
+  PfxEntry* new_pstart[SETSIZE];
+  PfxEntry* new_pflag[SETSIZE];
+  SfxEntry* new_sstart[SETSIZE];
+  SfxEntry* new_sflag[SETSIZE];
+  if (!load_affix_entries(in, this, prefixes, new_pstart, new_pflag) ||
+      !load_affix_entries(in, this, suffixes, new_sstart, new_sflag)) {
+    for (size_t i = 0; i < prefixes.size(); i++)
+      delete prefixes[i];
+    for (size_t i = 0; i < suffixes.size(); i++)
+      delete suffixes[i];
+    return false;
+  }
+  // owned by the manager from now on
+  for (int i = 0; i < SETSIZE; i++) {
+    pStart[i] = new_pstart[i];
+    pFlag[i] = new_pflag[i];
+    sStart[i] = new_sstart[i];
+    sFlag[i] = new_sflag[i];
+  }
+
+  int new_utf8;
+  in.get_string(keystring);
+  in.get_string(trystring);
+  in.get_string(encoding);
+  in.get_value(new_utf8);
+  in.get_value(complexprefixes);
+  in.get_value(compoundflag);
+  in.get_value(compoundbegin);
+  in.get_value(compoundmiddle);
+  in.get_value(compoundend);
+  in.get_value(compoundroot);
+  in.get_value(compoundforbidflag);
+  in.get_value(compoundpermitflag);
+  in.get_value(compoundmoresuffixes);
+  in.get_value(checkcompounddup);
+  in.get_value(checkcompoundrep);
+  in.get_value(checkcompoundcase);
+  in.get_value(checkcompoundtriple);
+  in.get_value(simplifiedtriple);
+  in.get_value(forbiddenword);
+  in.get_value(nosuggest);
+  in.get_value(nongramsuggest);
+  in.get_value(needaffix);
+  in.get_value(cpdmin);
+  in.get_value(parsedrep);
+  int count = 0;
+  in.get_value(count);
+  for (int i = 0; i < count && in.ok(); i++) {
+    replentry entry;
+    if (load_replentry(in, entry))
+      reptable.push_back(entry);
+  }
+  if (!load_convtable(in, &iconvtable) || !load_convtable(in, &oconvtable))
+    return false;
+  uint64_t tables = 0;
+  in.get_value(parsedmaptable);
+  in.get_value(tables);
+  for (uint64_t i = 0; i < tables && in.ok(); i++) {
+    maptable.push_back(mapentry());
+    load_strings(in, maptable.back());
+  }
+  in.get_value(parsedbreaktable);
+  load_strings(in, breaktable);
+  in.get_value(parsedcheckcpd);
+  tables = 0;
+  in.get_value(tables);
+  for (uint64_t i = 0; i < tables && in.ok(); i++) {
+    patentry entry;
+    in.get_string(entry.pattern);
+    in.get_string(entry.pattern2);
+    in.get_string(entry.pattern3);
+    in.get_value(entry.cond);
+    in.get_value(entry.cond2);
+    checkcpdtable.push_back(entry);
+  }
+  in.get_value(simplifiedcpd);
+  in.get_value(parseddefcpd);
+  tables = 0;
+  in.get_value(tables);
+  for (uint64_t i = 0; i < tables && in.ok(); i++) {
+    defcpdtable.push_back(flagentry());
+    in.get_vector(defcpdtable.back());
+  }
+  char has_phone = 0;
+  in.get_value(has_phone);
+  if (has_phone && in.ok()) {
+    phone = new phonetable;
+    in.get_value(phone->utf8);
+    // rules end with an empty pair
+    if (!load_strings(in, phone->rules) || phone->rules.size() < 2 ||
+        phone->rules.size() % 2 != 0)
+      return false;
+    init_phonet_hash(*phone);
+  }
+  in.get_value(maxngramsugs);
+  in.get_value(maxcpdsugs);
+  in.get_value(maxdiff);
+  in.get_value(onlymaxdiff);
+  in.get_value(nosplitsugs);
+  in.get_value(sugswithdots);
+  in.get_value(cpdwordmax);
+  in.get_value(cpdmaxsyllable);
+  in.get_string(cpdvowels);
+  in.get_vector(cpdvowels_utf16);
+  in.get_string(cpdsyllablenum);
+  in.get_value(checknum);
+  in.get_string(wordchars);
+  in.get_vector(wordchars_utf16);
+  in.get_string(ignorechars);
+  in.get_vector(ignorechars_utf16);
+  in.get_string(version);
+  in.get_string(lang);
+  in.get_value(langnum);
+  in.get_value(lemma_present);
+  in.get_value(circumfix);
+  in.get_value(onlyincompound);
+  in.get_value(keepcase);
+  in.get_value(forceucase);
+  in.get_value(warn);
+  in.get_value(forbidwarn);
+  in.get_value(substandard);
+  in.get_value(checksharps);
+  in.get_value(fullstrip);
+  in.get_value(havecontclass);
+  in.get_bytes(contclasses, sizeof(contclasses));
+  if (!in.ok())
+    return false;
+
+  // as set by parse_file()
+  if (new_utf8) {
+    utf8 = 1;
+#ifndef OPENOFFICEORG
+#ifndef MOZILLA_CLIENT
+    initialize_utf_tbl();
+#endif
+#endif
+  } else {
+    csconv = get_current_cs(get_encoding());
+  }
+  return true;
+}
+
 // read in aff file and build up prefix and suffix entry objects
 int AffixMgr::parse_file(const char* affpath, const char* key) {
 
@@ -1088,10 +1566,10 @@ struct hentry* AffixMgr::prefix_check(const char* word,
                                       const FLAG needflag) {
   struct hentry* rv = NULL;
 
-  pfx = NULL;
-  pfxappnd = NULL;
-  sfxappnd = NULL;
-  sfxextra = 0;
+  last_affix.pfx = NULL;
+  last_affix.pfxappnd = NULL;
+  last_affix.sfxappnd = NULL;
+  last_affix.sfxextra = 0;
 
   // first handle the special case of 0 length prefixes
   PfxEntry* pe = pStart[0];
@@ -1108,7 +1586,7 @@ struct hentry* AffixMgr::prefix_check(const char* word,
       // check prefix
       rv = pe->checkword(word, len, in_compound, needflag);
       if (rv) {
-        pfx = pe;  // BUG: pfx not stateless
+        last_affix.pfx = pe;
         return rv;
       }
     }
@@ -1133,7 +1611,7 @@ struct hentry* AffixMgr::prefix_check(const char* word,
         // check prefix
         rv = pptr->checkword(word, len, in_compound, needflag);
         if (rv) {
-          pfx = pptr;  // BUG: pfx not stateless
+          last_affix.pfx = pptr;
           return rv;
         }
       }
@@ -1153,9 +1631,9 @@ struct hentry* AffixMgr::prefix_check_twosfx(const char* word,
                                              const FLAG needflag) {
   struct hentry* rv = NULL;
 
-  pfx = NULL;
-  sfxappnd = NULL;
-  sfxextra = 0;
+  last_affix.pfx = NULL;
+  last_affix.sfxappnd = NULL;
+  last_affix.sfxextra = 0;
 
   // first handle the special case of 0 length prefixes
   PfxEntry* pe = pStart[0];
@@ -1175,7 +1653,7 @@ struct hentry* AffixMgr::prefix_check_twosfx(const char* word,
     if (isSubset(pptr->getKey(), word)) {
       rv = pptr->check_twosfx(word, len, in_compound, needflag);
       if (rv) {
-        pfx = pptr;
+        last_affix.pfx = pptr;
         return rv;
       }
       pptr = pptr->getNextEQ();
@@ -1195,9 +1673,9 @@ std::string AffixMgr::prefix_check_morph(const char* word,
 
   std::string result;
 
-  pfx = NULL;
-  sfxappnd = NULL;
-  sfxextra = 0;
+  last_affix.pfx = NULL;
+  last_affix.sfxappnd = NULL;
+  last_affix.sfxextra = 0;
 
   // first handle the special case of 0 length prefixes
   PfxEntry* pe = pStart[0];
@@ -1222,7 +1700,7 @@ std::string AffixMgr::prefix_check_morph(const char* word,
             !((pptr->getCont() && (TESTAFF(pptr->getCont(), onlyincompound,
                                            pptr->getContLen()))))) {
           result.append(st);
-          pfx = pptr;
+          last_affix.pfx = pptr;
         }
       }
       pptr = pptr->getNextEQ();
@@ -1241,9 +1719,9 @@ std::string AffixMgr::prefix_check_twosfx_morph(const char* word,
                                                 const FLAG needflag) {
   std::string result;
 
-  pfx = NULL;
-  sfxappnd = NULL;
-  sfxextra = 0;
+  last_affix.pfx = NULL;
+  last_affix.sfxappnd = NULL;
+  last_affix.sfxextra = 0;
 
   // first handle the special case of 0 length prefixes
   PfxEntry* pe = pStart[0];
@@ -1264,7 +1742,7 @@ std::string AffixMgr::prefix_check_twosfx_morph(const char* word,
       std::string st = pptr->check_twosfx_morph(word, len, in_compound, needflag);
       if (!st.empty()) {
         result.append(st);
-        pfx = pptr;
+        last_affix.pfx = pptr;
       }
       pptr = pptr->getNextEQ();
     } else {
@@ -1639,8 +2117,8 @@ struct hentry* AffixMgr::compound_check(const std::string& word,
         ch = st[i];
         st[i] = '\0';
 
-        sfx = NULL;
-        pfx = NULL;
+        last_affix.sfx = NULL;
+        last_affix.pfx = NULL;
 
         // FIRST WORD
 
@@ -1681,12 +2159,13 @@ struct hentry* AffixMgr::compound_check(const std::string& word,
                       hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) ||
                  (compoundmoresuffixes &&
                   (rv = suffix_check_twosfx(st.c_str(), i, 0, NULL, compoundflag)))) &&
-                !hu_mov_rule && sfx->getCont() &&
+                !hu_mov_rule && last_affix.sfx->getCont() &&
                 ((compoundforbidflag &&
-                  TESTAFF(sfx->getCont(), compoundforbidflag,
-                          sfx->getContLen())) ||
+                  TESTAFF(last_affix.sfx->getCont(), compoundforbidflag,
+                          last_affix.sfx->getContLen())) ||
                  (compoundend &&
-                  TESTAFF(sfx->getCont(), compoundend, sfx->getContLen())))) {
+                  TESTAFF(last_affix.sfx->getCont(), compoundend,
+                          last_affix.sfx->getContLen())))) {
               rv = NULL;
             }
           }
@@ -1728,30 +2207,35 @@ struct hentry* AffixMgr::compound_check(const std::string& word,
 
         // check non_compound flag in suffix and prefix
         if ((rv) && !hu_mov_rule &&
-            ((pfx && pfx->getCont() &&
-              TESTAFF(pfx->getCont(), compoundforbidflag, pfx->getContLen())) ||
-             (sfx && sfx->getCont() &&
-              TESTAFF(sfx->getCont(), compoundforbidflag,
-                      sfx->getContLen())))) {
+            ((last_affix.pfx && last_affix.pfx->getCont() &&
+              TESTAFF(last_affix.pfx->getCont(), compoundforbidflag,
+                      last_affix.pfx->getContLen())) ||
+             (last_affix.sfx && last_affix.sfx->getCont() &&
+              TESTAFF(last_affix.sfx->getCont(), compoundforbidflag,
+                      last_affix.sfx->getContLen())))) {
           rv = NULL;
         }
 
         // check compoundend flag in suffix and prefix
         if ((rv) && !checked_prefix && compoundend && !hu_mov_rule &&
-            ((pfx && pfx->getCont() &&
-              TESTAFF(pfx->getCont(), compoundend, pfx->getContLen())) ||
-             (sfx && sfx->getCont() &&
-              TESTAFF(sfx->getCont(), compoundend, sfx->getContLen())))) {
+            ((last_affix.pfx && last_affix.pfx->getCont() &&
+              TESTAFF(last_affix.pfx->getCont(), compoundend,
+                      last_affix.pfx->getContLen())) ||
+             (last_affix.sfx && last_affix.sfx->getCont() &&
+              TESTAFF(last_affix.sfx->getCont(), compoundend,
+                      last_affix.sfx->getContLen())))) {
           rv = NULL;
         }
 
         // check compoundmiddle flag in suffix and prefix
         if ((rv) && !checked_prefix && (wordnum == 0) && compoundmiddle &&
             !hu_mov_rule &&
-            ((pfx && pfx->getCont() &&
-              TESTAFF(pfx->getCont(), compoundmiddle, pfx->getContLen())) ||
-             (sfx && sfx->getCont() &&
-              TESTAFF(sfx->getCont(), compoundmiddle, sfx->getContLen())))) {
+            ((last_affix.pfx && last_affix.pfx->getCont() &&
+              TESTAFF(last_affix.pfx->getCont(), compoundmiddle,
+                      last_affix.pfx->getContLen())) ||
+             (last_affix.sfx && last_affix.sfx->getCont() &&
+              TESTAFF(last_affix.sfx->getCont(), compoundmiddle,
+                      last_affix.sfx->getContLen())))) {
           rv = NULL;
         }
 
@@ -1802,13 +2286,13 @@ struct hentry* AffixMgr::compound_check(const std::string& word,
             // LANG_hu section: spec. Hungarian rule
             || ((!rv) && (langnum == LANG_hu) && hu_mov_rule &&
                 (rv = affix_check(st.c_str(), i)) &&
-                (sfx && sfx->getCont() &&
+                (last_affix.sfx && last_affix.sfx->getCont() &&
                  (  // XXX hardwired Hungarian dic. codes
-                     TESTAFF(sfx->getCont(), (unsigned short)'x',
-                             sfx->getContLen()) ||
+                     TESTAFF(last_affix.sfx->getCont(), (unsigned short)'x',
+                             last_affix.sfx->getContLen()) ||
                      TESTAFF(
-                         sfx->getCont(), (unsigned short)'%',
-                         sfx->getContLen()))))) {  // first word is ok condition
+                         last_affix.sfx->getCont(), (unsigned short)'%',
+                         last_affix.sfx->getContLen()))))) {  // first word is ok condition
 
           // LANG_hu section: spec. Hungarian rule
           if (langnum == LANG_hu) {
@@ -1816,7 +2300,7 @@ struct hentry* AffixMgr::compound_check(const std::string& word,
             numsyllable += get_syllable(st.substr(0, i));
             // + 1 word, if syllable number of the prefix > 1 (hungarian
             // convention)
-            if (pfx && (get_syllable(pfx->getKey()) > 1))
+            if (last_affix.pfx && (get_syllable(last_affix.pfx->getKey()) > 1))
               wordnum++;
           }
           // END of LANG_hu section
@@ -1920,15 +2404,15 @@ struct hentry* AffixMgr::compound_check(const std::string& word,
             wordnum = oldwordnum2;
 
             // perhaps second word has prefix or/and suffix
-            sfx = NULL;
-            sfxflag = FLAG_NULL;
+            last_affix.sfx = NULL;
+            last_affix.sfxflag = FLAG_NULL;
             rv = (compoundflag && !onlycpdrule)
                      ? affix_check((word.c_str() + i), strlen(word.c_str() + i), compoundflag,
                                    IN_CPD_END)
                      : NULL;
             if (!rv && compoundend && !onlycpdrule) {
-              sfx = NULL;
-              pfx = NULL;
+              last_affix.sfx = NULL;
+              last_affix.pfx = NULL;
               rv = affix_check((word.c_str() + i), strlen(word.c_str() + i), compoundend,
                                IN_CPD_END);
             }
@@ -1952,12 +2436,12 @@ struct hentry* AffixMgr::compound_check(const std::string& word,
               rv = NULL;
 
             // check non_compound flag in suffix and prefix
-            if ((rv) && ((pfx && pfx->getCont() &&
-                          TESTAFF(pfx->getCont(), compoundforbidflag,
-                                  pfx->getContLen())) ||
-                         (sfx && sfx->getCont() &&
-                          TESTAFF(sfx->getCont(), compoundforbidflag,
-                                  sfx->getContLen())))) {
+            if ((rv) && ((last_affix.pfx && last_affix.pfx->getCont() &&
+                          TESTAFF(last_affix.pfx->getCont(), compoundforbidflag,
+                                  last_affix.pfx->getContLen())) ||
+                         (last_affix.sfx && last_affix.sfx->getCont() &&
+                          TESTAFF(last_affix.sfx->getCont(), compoundforbidflag,
+                                  last_affix.sfx->getContLen())))) {
               rv = NULL;
             }
 
@@ -1986,22 +2470,23 @@ struct hentry* AffixMgr::compound_check(const std::string& word,
 
               // - affix syllable num.
               // XXX only second suffix (inflections, not derivations)
-              if (sfxappnd) {
-                std::string tmp(sfxappnd);
+              if (last_affix.sfxappnd) {
+                std::string tmp(last_affix.sfxappnd);
                 reverseword(tmp);
-                numsyllable -= get_syllable(tmp) + sfxextra;
+                numsyllable -= get_syllable(tmp) + last_affix.sfxextra;
               }
 
               // + 1 word, if syllable number of the prefix > 1 (hungarian
               // convention)
-              if (pfx && (get_syllable(pfx->getKey()) > 1))
+              if (last_affix.pfx &&
+                  (get_syllable(last_affix.pfx->getKey()) > 1))
                 wordnum++;
 
               // increment syllable num, if last word has a SYLLABLENUM flag
               // and the suffix is beginning `s'
 
               if (!cpdsyllablenum.empty()) {
-                switch (sfxflag) {
+                switch (last_affix.sfxflag) {
                   case 'c': {
                     numsyllable += 2;
                     break;
@@ -2186,7 +2671,7 @@ int AffixMgr::compound_check_morph(const char* word,
 
       ch = st[i];
       st[i] = '\0';
-      sfx = NULL;
+      last_affix.sfx = NULL;
 
       // FIRST WORD
 
@@ -2243,12 +2728,13 @@ int AffixMgr::compound_check_morph(const char* word,
                                   hu_mov_rule ? IN_CPD_OTHER : IN_CPD_BEGIN)) ||
                (compoundmoresuffixes &&
                 (rv = suffix_check_twosfx(st.c_str(), i, 0, NULL, compoundflag)))) &&
-              !hu_mov_rule && sfx->getCont() &&
+              !hu_mov_rule && last_affix.sfx->getCont() &&
               ((compoundforbidflag &&
-                TESTAFF(sfx->getCont(), compoundforbidflag,
-                        sfx->getContLen())) ||
+                TESTAFF(last_affix.sfx->getCont(), compoundforbidflag,
+                        last_affix.sfx->getContLen())) ||
                (compoundend &&
-                TESTAFF(sfx->getCont(), compoundend, sfx->getContLen())))) {
+                TESTAFF(last_affix.sfx->getCont(), compoundend,
+                        last_affix.sfx->getContLen())))) {
             rv = NULL;
           }
         }
@@ -2305,29 +2791,35 @@ int AffixMgr::compound_check_morph(const char* word,
 
       // check non_compound flag in suffix and prefix
       if ((rv) && !hu_mov_rule &&
-          ((pfx && pfx->getCont() &&
-            TESTAFF(pfx->getCont(), compoundforbidflag, pfx->getContLen())) ||
-           (sfx && sfx->getCont() &&
-            TESTAFF(sfx->getCont(), compoundforbidflag, sfx->getContLen())))) {
+          ((last_affix.pfx && last_affix.pfx->getCont() &&
+            TESTAFF(last_affix.pfx->getCont(), compoundforbidflag,
+                    last_affix.pfx->getContLen())) ||
+           (last_affix.sfx && last_affix.sfx->getCont() &&
+            TESTAFF(last_affix.sfx->getCont(), compoundforbidflag,
+                    last_affix.sfx->getContLen())))) {
         continue;
       }
 
       // check compoundend flag in suffix and prefix
       if ((rv) && !checked_prefix && compoundend && !hu_mov_rule &&
-          ((pfx && pfx->getCont() &&
-            TESTAFF(pfx->getCont(), compoundend, pfx->getContLen())) ||
-           (sfx && sfx->getCont() &&
-            TESTAFF(sfx->getCont(), compoundend, sfx->getContLen())))) {
+          ((last_affix.pfx && last_affix.pfx->getCont() &&
+            TESTAFF(last_affix.pfx->getCont(), compoundend,
+                    last_affix.pfx->getContLen())) ||
+           (last_affix.sfx && last_affix.sfx->getCont() &&
+            TESTAFF(last_affix.sfx->getCont(), compoundend,
+                    last_affix.sfx->getContLen())))) {
         continue;
       }
 
       // check compoundmiddle flag in suffix and prefix
       if ((rv) && !checked_prefix && (wordnum == 0) && compoundmiddle &&
           !hu_mov_rule &&
-          ((pfx && pfx->getCont() &&
-            TESTAFF(pfx->getCont(), compoundmiddle, pfx->getContLen())) ||
-           (sfx && sfx->getCont() &&
-            TESTAFF(sfx->getCont(), compoundmiddle, sfx->getContLen())))) {
+          ((last_affix.pfx && last_affix.pfx->getCont() &&
+            TESTAFF(last_affix.pfx->getCont(), compoundmiddle,
+                    last_affix.pfx->getContLen())) ||
+           (last_affix.sfx && last_affix.sfx->getCont() &&
+            TESTAFF(last_affix.sfx->getCont(), compoundmiddle,
+                    last_affix.sfx->getContLen())))) {
         rv = NULL;
       }
 
@@ -2371,9 +2863,11 @@ int AffixMgr::compound_check_morph(const char* word,
           ||
           ((!rv) && (langnum == LANG_hu) && hu_mov_rule &&
            (rv = affix_check(st.c_str(), i)) &&
-           (sfx && sfx->getCont() &&
-            (TESTAFF(sfx->getCont(), (unsigned short)'x', sfx->getContLen()) ||
-             TESTAFF(sfx->getCont(), (unsigned short)'%', sfx->getContLen()))))
+           (last_affix.sfx && last_affix.sfx->getCont() &&
+            (TESTAFF(last_affix.sfx->getCont(), (unsigned short)'x',
+                     last_affix.sfx->getContLen()) ||
+             TESTAFF(last_affix.sfx->getCont(), (unsigned short)'%',
+                     last_affix.sfx->getContLen()))))
           // END of LANG_hu section
           ) {
         // LANG_hu section: spec. Hungarian rule
@@ -2383,7 +2877,7 @@ int AffixMgr::compound_check_morph(const char* word,
 
           // + 1 word, if syllable number of the prefix > 1 (hungarian
           // convention)
-          if (pfx && (get_syllable(pfx->getKey()) > 1))
+          if (last_affix.pfx && (get_syllable(last_affix.pfx->getKey()) > 1))
             wordnum++;
         }
         // END of LANG_hu section
@@ -2488,8 +2982,8 @@ int AffixMgr::compound_check_morph(const char* word,
         wordnum = oldwordnum2;
 
         // perhaps second word has prefix or/and suffix
-        sfx = NULL;
-        sfxflag = FLAG_NULL;
+        last_affix.sfx = NULL;
+        last_affix.sfxflag = FLAG_NULL;
 
         if (compoundflag && !onlycpdrule)
           rv = affix_check((word + i), strlen(word + i), compoundflag);
@@ -2497,8 +2991,8 @@ int AffixMgr::compound_check_morph(const char* word,
           rv = NULL;
 
         if (!rv && compoundend && !onlycpdrule) {
-          sfx = NULL;
-          pfx = NULL;
+          last_affix.sfx = NULL;
+          last_affix.pfx = NULL;
           rv = affix_check((word + i), strlen(word + i), compoundend);
         }
 
@@ -2526,11 +3020,12 @@ int AffixMgr::compound_check_morph(const char* word,
 
         // check non_compound flag in suffix and prefix
         if ((rv) &&
-            ((pfx && pfx->getCont() &&
-              TESTAFF(pfx->getCont(), compoundforbidflag, pfx->getContLen())) ||
-             (sfx && sfx->getCont() &&
-              TESTAFF(sfx->getCont(), compoundforbidflag,
-                      sfx->getContLen())))) {
+            ((last_affix.pfx && last_affix.pfx->getCont() &&
+              TESTAFF(last_affix.pfx->getCont(), compoundforbidflag,
+                      last_affix.pfx->getContLen())) ||
+             (last_affix.sfx && last_affix.sfx->getCont() &&
+              TESTAFF(last_affix.sfx->getCont(), compoundforbidflag,
+                      last_affix.sfx->getContLen())))) {
           rv = NULL;
         }
 
@@ -2549,22 +3044,22 @@ int AffixMgr::compound_check_morph(const char* word,
 
           // - affix syllable num.
           // XXX only second suffix (inflections, not derivations)
-          if (sfxappnd) {
-            std::string tmp(sfxappnd);
+          if (last_affix.sfxappnd) {
+            std::string tmp(last_affix.sfxappnd);
             reverseword(tmp);
-            numsyllable -= get_syllable(tmp) + sfxextra;
+            numsyllable -= get_syllable(tmp) + last_affix.sfxextra;
           }
 
           // + 1 word, if syllable number of the prefix > 1 (hungarian
           // convention)
-          if (pfx && (get_syllable(pfx->getKey()) > 1))
+          if (last_affix.pfx && (get_syllable(last_affix.pfx->getKey()) > 1))
             wordnum++;
 
           // increment syllable num, if last word has a SYLLABLENUM flag
           // and the suffix is beginning `s'
 
           if (!cpdsyllablenum.empty()) {
-            switch (sfxflag) {
+            switch (last_affix.sfxflag) {
               case 'c': {
                 numsyllable += 2;
                 break;
@@ -2694,7 +3189,7 @@ struct hentry* AffixMgr::suffix_check(const char* word,
                            (FLAG)cclass, needflag,
                            (in_compound ? 0 : onlyincompound));
         if (rv) {
-          sfx = se;  // BUG: sfx not stateless
+          last_affix.sfx = se;
           return rv;
         }
       }
@@ -2745,15 +3240,15 @@ struct hentry* AffixMgr::suffix_check(const char* word,
                                cclass, needflag,
                                (in_compound ? 0 : onlyincompound));
           if (rv) {
-            sfx = sptr;                 // BUG: sfx not stateless
-            sfxflag = sptr->getFlag();  // BUG: sfxflag not stateless
+            last_affix.sfx = sptr;
+            last_affix.sfxflag = sptr->getFlag();
             if (!sptr->getCont())
-              sfxappnd = sptr->getKey();  // BUG: sfxappnd not stateless
+              last_affix.sfxappnd = sptr->getKey();
             // LANG_hu section: spec. Hungarian rule
             else if (langnum == LANG_hu && sptr->getKeyLen() &&
                      sptr->getKey()[0] == 'i' && sptr->getKey()[1] != 'y' &&
                      sptr->getKey()[1] != 't') {
-              sfxextra = 1;
+              last_affix.sfxextra = 1;
             }
             // END of LANG_hu section
             return rv;
@@ -2799,9 +3294,9 @@ struct hentry* AffixMgr::suffix_check_twosfx(const char* word,
       if (contclasses[sptr->getFlag()]) {
         rv = sptr->check_twosfx(word, len, sfxopts, ppfx, needflag);
         if (rv) {
-          sfxflag = sptr->getFlag();  // BUG: sfxflag not stateless
+          last_affix.sfxflag = sptr->getFlag();
           if (!sptr->getCont())
-            sfxappnd = sptr->getKey();  // BUG: sfxappnd not stateless
+            last_affix.sfxappnd = sptr->getKey();
           return rv;
         }
       }
@@ -2859,9 +3354,9 @@ std::string AffixMgr::suffix_check_twosfx_morph(const char* word,
       if (contclasses[sptr->getFlag()]) {
         std::string st = sptr->check_twosfx_morph(word, len, sfxopts, ppfx, needflag);
         if (!st.empty()) {
-          sfxflag = sptr->getFlag();  // BUG: sfxflag not stateless
+          last_affix.sfxflag = sptr->getFlag();
           if (!sptr->getCont())
-            sfxappnd = sptr->getKey();  // BUG: sfxappnd not stateless
+            last_affix.sfxappnd = sptr->getKey();
           result2.assign(st);
 
           result3.clear();
@@ -3051,8 +3546,8 @@ struct hentry* AffixMgr::affix_check(const char* word,
   rv = suffix_check(word, len, 0, NULL, FLAG_NULL, needflag, in_compound);
 
   if (havecontclass) {
-    sfx = NULL;
-    pfx = NULL;
+    last_affix.sfx = NULL;
+    last_affix.pfx = NULL;
 
     if (rv)
       return rv;
@@ -3088,8 +3583,8 @@ std::string AffixMgr::affix_check_morph(const char* word,
   }
 
   if (havecontclass) {
-    sfx = NULL;
-    pfx = NULL;
+    last_affix.sfx = NULL;
+    last_affix.pfx = NULL;
     // if still not found check all two-level suffixes
     st = suffix_check_twosfx_morph(word, len, 0, NULL, needflag);
     if (!st.empty()) {
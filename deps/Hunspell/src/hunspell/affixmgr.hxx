@@ -145,13 +145,7 @@ class AffixMgr {
   std::string cpdvowels; // vowels (for calculating of Hungarian compounding limit,
   std::vector<w_char> cpdvowels_utf16; //vowels for UTF-8 encoding
   std::string cpdsyllablenum; // syllable count incrementing flag
-  const char* pfxappnd;  // BUG: not stateless
-  const char* sfxappnd;  // BUG: not stateless
-  int sfxextra;          // BUG: not stateless
-  FLAG sfxflag;          // BUG: not stateless
   char* derived;         // BUG: not stateless
-  SfxEntry* sfx;         // BUG: not stateless
-  PfxEntry* pfx;         // BUG: not stateless
   int checknum;
   std::string wordchars; // letters + spec. word characters
   std::vector<w_char> wordchars_utf16;
@@ -177,7 +171,14 @@ class AffixMgr {
 
  public:
   AffixMgr(const char* affpath, const std::vector<HashMgr*>& ptr, const char* key = NULL);
+  // without affix data, to be restored by load_snapshot()
+  explicit AffixMgr(const std::vector<HashMgr*>& ptr);
   ~AffixMgr();
+  // restores the parsed affix file stored with the first dictionary, the
+  // manager is left incomplete and has to be deleted if this fails
+  bool load_snapshot();
+  // stores the parsed affix file with the dictionary for the next loads
+  void save_snapshot(const HashMgr* dic) const;
   struct hentry* affix_check(const char* word,
                              int len,
                              const unsigned short needflag = (unsigned short)0,
@@ -54,6 +54,9 @@ static inline void HUNSPELL_WARNING(FILE*, const char*, ...) {}
 
 #include "w_char.hxx"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -116,4 +119,26 @@ struct patentry {
   }
 };
 
+// wall-clock deadline, cancellation flag and maximal number of returned
+// suggestions (0: all) of a suggestion request
+struct suggest_limits {
+  std::chrono::steady_clock::time_point deadline;
+  const std::atomic<bool>* cancelled;
+  unsigned int max_count;
+  suggest_limits()
+    : deadline(std::chrono::steady_clock::time_point::max())
+    , cancelled(NULL)
+    , max_count(0) {
+  }
+  bool reached() const {
+    return (cancelled && cancelled->load(std::memory_order_relaxed)) ||
+           (deadline != std::chrono::steady_clock::time_point::max() &&
+            std::chrono::steady_clock::now() >= deadline);
+  }
+};
+
+// receives suggestions found before a slower search step
+typedef std::function<void(const std::vector<std::string>&)>
+    suggest_tier_callback;
+
 #endif
@@ -73,6 +73,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <mutex>
 #include <sstream>
 
 #include "csutil.hxx"
@@ -119,6 +120,8 @@ struct unicode_info2 {
 static struct unicode_info2* utf_tbl = NULL;
 static int utf_tbl_count =
     0;  // utf_tbl can be used by multiple Hunspell instances
+// instances can be created and destroyed from different threads
+static std::mutex utf_tbl_mutex;
 
 void myopen(std::ifstream& stream, const char* path, std::ios_base::openmode mode)
 {
@@ -2427,6 +2430,7 @@ int get_lang_num(const std::string& lang) {
 #ifndef OPENOFFICEORG
 #ifndef MOZILLA_CLIENT
 void initialize_utf_tbl() {
+  std::lock_guard<std::mutex> lock(utf_tbl_mutex);
   utf_tbl_count++;
   if (utf_tbl)
     return;
@@ -2446,6 +2450,7 @@ void initialize_utf_tbl() {
 #endif
 
 void free_utf_tbl() {
+  std::lock_guard<std::mutex> lock(utf_tbl_mutex);
   if (utf_tbl_count > 0)
     utf_tbl_count--;
   if (utf_tbl && (utf_tbl_count == 0)) {
@@ -0,0 +1,321 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "dicsnapshot.hxx"
+#include "htypes.hxx"
+
+#define SNAPSHOT_MAGIC "HUNSNAP"
+// layout version, snapshots of other builds are not compatible
+#define SNAPSHOT_FORMAT \
+  (5 | (sizeof(struct hentry) << 8) | (sizeof(long) << 16))
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+// bytes of source files hashed
+#define SNAPSHOT_SOURCE_HEAD 4096
+// image start is aligned to cache line
+#define SNAPSHOT_HEADER_ALIGN 64
+
+struct snapshot_header {
+  char magic[8];
+  uint32_t format;
+  uint32_t byte_order;
+  uint32_t pointer_size;
+  uint32_t reserved;
+  snapshot_source sources[2];
+  uint64_t image_base;
+  uint64_t image_size;
+  uint64_t checksum;
+};
+
+// processed by 8 byte words, so checking the image costs little compared
+// to parsing
+static uint64_t hash_bytes(const char* data, size_t len) {
+  uint64_t hash = 14695981039346656037ULL;
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    hash = (hash ^ word) * 1099511628211ULL;
+    hash ^= hash >> 29;
+  }
+  for (; i < len; ++i)
+    hash = (hash ^ (unsigned char)data[i]) * 1099511628211ULL;
+  return hash;
+}
+
+// modification time has subsecond precision where the file system keeps it,
+// the head of the file catches changes within the same tick
+static bool stamp_file(const char* path, snapshot_source& source) {
+#ifdef _WIN32
+  WIN32_FILE_ATTRIBUTE_DATA attributes;
+  if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes))
+    return false;
+  source.size = ((uint64_t)attributes.nFileSizeHigh << 32) |
+                attributes.nFileSizeLow;
+  source.mtime = ((uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) |
+                 attributes.ftLastWriteTime.dwLowDateTime;
+#else
+  struct stat st;
+  if (stat(path, &st) != 0)
+    return false;
+  source.size = (uint64_t)st.st_size;
+#ifdef __APPLE__
+  source.mtime = (uint64_t)st.st_mtimespec.tv_sec * 1000000000 +
+                 st.st_mtimespec.tv_nsec;
+#else
+  source.mtime =
+      (uint64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+  FILE* fp = fopen(path, "rb");
+  if (!fp)
+    return false;
+  char head[SNAPSHOT_SOURCE_HEAD];
+  size_t len = fread(head, 1, sizeof(head), fp);
+  bool ok = !ferror(fp);
+  fclose(fp);
+  source.hash = hash_bytes(head, len);
+  return ok;
+}
+
+static bool same_source(const snapshot_source& a, const snapshot_source& b) {
+  return a.size == b.size && a.mtime == b.mtime && a.hash == b.hash;
+}
+
+DicSnapshot::DicSnapshot(const char* affpath, const char* dpath)
+    : path(std::string(dpath) + ".snapshot"),
+      sources_valid(false),
+      base(NULL),
+      size(0)
+#ifdef _WIN32
+      ,
+      mapping(NULL)
+#endif
+{
+  memset(sources, 0, sizeof(sources));
+  // long UTF-8 paths are opened specially by myopen(), snapshots are
+  // not supported for them
+  if (strncmp(dpath, "\\\\?\\", 4) == 0)
+    return;
+  sources_valid =
+      stamp_file(affpath, sources[0]) && stamp_file(dpath, sources[1]);
+}
+
+DicSnapshot::~DicSnapshot() {
+  unmap();
+}
+
+size_t DicSnapshot::header_size() {
+  return (sizeof(snapshot_header) + SNAPSHOT_HEADER_ALIGN - 1) /
+         SNAPSHOT_HEADER_ALIGN * SNAPSHOT_HEADER_ALIGN;
+}
+
+uint64_t DicSnapshot::preferred_base() const {
+  // dictionaries are spread over 64 MB slots between 768 MB and 1.8 GB,
+  // which are rarely taken by system libraries or early allocations
+  // of 32-bit processes, larger images are relocated
+  if (sizeof(void*) < 8)
+    return 0x30000000ULL + (sources[1].hash & 0xF) * 0x4000000ULL +
+           header_size();
+  // spread dictionaries over 4 GB slots of otherwise unused
+  // part of 64-bit address space
+  return 0x100000000000ULL + ((sources[1].hash & 0x3FF) << 32) +
+         header_size();
+}
+
+char* DicSnapshot::map(uint64_t& image_base, size_t& image_size) {
+  unmap();
+  if (!sources_valid)
+    return NULL;
+
+  void* hint = (void*)(uintptr_t)(preferred_base() - header_size());
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return NULL;
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) ||
+      (uint64_t)file_size.QuadPart < header_size() ||
+      (uint64_t)file_size.QuadPart > (size_t)-1) {
+    CloseHandle(file);
+    return NULL;
+  }
+  mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping)
+    return NULL;
+  base = (char*)MapViewOfFileEx(mapping, FILE_MAP_COPY, 0, 0, 0, hint);
+  if (!base)
+    base = (char*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+  if (!base) {
+    unmap();
+    return NULL;
+  }
+  size = (size_t)file_size.QuadPart;
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < header_size()) {
+    close(fd);
+    return NULL;
+  }
+  void* p = mmap(hint, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED)
+    return NULL;
+  base = (char*)p;
+  size = (size_t)st.st_size;
+#endif
+
+  const snapshot_header* header = (const snapshot_header*)base;
+  if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+      header->format != SNAPSHOT_FORMAT ||
+      header->byte_order != SNAPSHOT_BYTE_ORDER ||
+      header->pointer_size != sizeof(void*) ||
+      !same_source(header->sources[0], sources[0]) ||
+      !same_source(header->sources[1], sources[1]) ||
+      header->image_size != size - header_size() ||
+      header->checksum != hash_bytes(base + header_size(),
+                                     size - header_size())) {
+    unmap();
+    return NULL;
+  }
+  image_base = header->image_base;
+  image_size = (size_t)header->image_size;
+  return base + header_size();
+}
+
+void DicSnapshot::unmap() {
+#ifdef _WIN32
+  if (base)
+    UnmapViewOfFile(base);
+  if (mapping)
+    CloseHandle(mapping);
+  mapping = NULL;
+#else
+  if (base)
+    munmap(base, size);
+#endif
+  base = NULL;
+  size = 0;
+}
+
+void DicSnapshot::save(const std::vector<char>& image) const {
+  if (!sources_valid)
+    return;
+
+  snapshot_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.format = SNAPSHOT_FORMAT;
+  header.byte_order = SNAPSHOT_BYTE_ORDER;
+  header.pointer_size = sizeof(void*);
+  header.sources[0] = sources[0];
+  header.sources[1] = sources[1];
+  header.image_base = preferred_base();
+  header.image_size = image.size();
+  header.checksum = image.empty() ? hash_bytes(NULL, 0)
+                                  : hash_bytes(&image[0], image.size());
+  std::vector<char> padding(header_size() - sizeof(header));
+
+  // written under temporary name, so other processes never map
+  // partially written snapshot
+  char suffix[32];
+#ifdef _WIN32
+  sprintf(suffix, ".%d.tmp", _getpid());
+#else
+  sprintf(suffix, ".%d.tmp", (int)getpid());
+#endif
+  std::string tmp_path = path + suffix;
+  FILE* fp = fopen(tmp_path.c_str(), "wb");
+  if (!fp)
+    return;
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+            (padding.empty() ||
+             fwrite(&padding[0], padding.size(), 1, fp) == 1) &&
+            (image.empty() || fwrite(&image[0], image.size(), 1, fp) == 1);
+  ok = fclose(fp) == 0 && ok;
+#ifdef _WIN32
+  // fails while old snapshot is mapped by another process, it's replaced
+  // next time then
+  ok = ok && MoveFileExA(tmp_path.c_str(), path.c_str(),
+                         MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  ok = ok && rename(tmp_path.c_str(), path.c_str()) == 0;
+#endif
+  if (!ok)
+    remove(tmp_path.c_str());
+}
+
+bool SnapshotReader::get_bytes(void* data, size_t len) {
+  const char* p = get_view(len);
+  if (!p)
+    return false;
+  if (len)
+    memcpy(data, p, len);
+  return true;
+}
+
+const char* SnapshotReader::get_view(size_t len) {
+  if (!next || len > (size_t)(end - next)) {
+    fail();
+    return NULL;
+  }
+  const char* p = next;
+  next += len;
+  return p;
+}
+
+bool SnapshotReader::get_string(std::string& s) {
+  uint64_t len;
+  if (!get_value(len) || len > (uint64_t)(end - next))
+    return fail();
+  s.assign(next, (size_t)len);
+  next += len;
+  return true;
+}
@@ -0,0 +1,146 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/* Compiled snapshot of a parsed dictionary, stored next to the .dic file.
+ *
+ * Snapshot is a memory image laid out for a preferred base address, if it
+ * can be mapped there no relocation is needed and pages stay shared between
+ * processes using the same dictionary. Mapping is copy-on-write, so image
+ * can be modified in place (e.g. when personal words are added).
+ *
+ * Snapshot is used only if size, modification time and hash of the first
+ * 4 KB of both .aff and .dic files are the same as when it was written, so
+ * checking it costs no more than opening the files. Checksum of the image
+ * guards against damaged snapshots.
+ */
+
+#ifndef DICSNAPSHOT_HXX_
+#define DICSNAPSHOT_HXX_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// appends values to a section of the image, values are stored in memory
+// layout of the build which wrote them like the rest of the image
+class SnapshotWriter {
+  std::vector<char>& out;
+
+ public:
+  explicit SnapshotWriter(std::vector<char>& buffer) : out(buffer) {}
+  void put_bytes(const void* data, size_t len) {
+    out.insert(out.end(), (const char*)data, (const char*)data + len);
+  }
+  template <typename T>
+  void put_value(const T& value) {
+    put_bytes(&value, sizeof(value));
+  }
+  void put_string(const std::string& s) {
+    put_value((uint64_t)s.size());
+    put_bytes(s.data(), s.size());
+  }
+  // elements must be plain values
+  template <typename T>
+  void put_vector(const std::vector<T>& v) {
+    put_value((uint64_t)v.size());
+    if (!v.empty())
+      put_bytes(&v[0], v.size() * sizeof(T));
+  }
+};
+
+// reads values written by SnapshotWriter, reads are checked against the end
+// of the section and all of them fail after the first failure
+class SnapshotReader {
+  const char* next;
+  const char* end;
+
+ public:
+  SnapshotReader(const char* data, size_t size)
+      : next(data), end(data + size) {}
+  bool ok() const { return next != NULL; }
+  bool get_bytes(void* data, size_t len);
+  // returns len bytes in place, NULL if there are not so many
+  const char* get_view(size_t len);
+  template <typename T>
+  bool get_value(T& value) {
+    return get_bytes(&value, sizeof(value));
+  }
+  bool get_string(std::string& s);
+  template <typename T>
+  bool get_vector(std::vector<T>& v) {
+    uint64_t n;
+    if (!get_value(n) || n > (uint64_t)(end - next) / sizeof(T))
+      return fail();
+    v.resize((size_t)n);
+    return v.empty() || get_bytes(&v[0], v.size() * sizeof(T));
+  }
+
+ private:
+  bool fail() {
+    next = NULL;
+    end = NULL;
+    return false;
+  }
+};
+
+struct snapshot_source {
+  uint64_t size;
+  uint64_t mtime;
+  uint64_t hash;
+};
+
+class DicSnapshot {
+  std::string path;
+  snapshot_source sources[2];
+  bool sources_valid;
+  char* base;
+  size_t size;
+#ifdef _WIN32
+  void* mapping;
+#endif
+
+ public:
+  DicSnapshot(const char* affpath, const char* dpath);
+  ~DicSnapshot();
+
+  // address image should be laid out for
+  uint64_t preferred_base() const;
+  // size of header preceding the image, image offsets start after it
+  static size_t header_size();
+  // map snapshot if it is up to date and intact, returns image start or
+  // NULL; image_base receives the address image was laid out for
+  char* map(uint64_t& image_base, size_t& image_size);
+  void unmap();
+  bool contains(const void* p) const {
+    return base && (const char*)p >= base && (const char*)p < base + size;
+  }
+  // write image laid out for preferred_base(), failures are ignored
+  void save(const std::vector<char>& image) const;
+};
+
+#endif
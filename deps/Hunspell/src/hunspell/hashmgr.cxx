@@ -72,18 +72,66 @@
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <algorithm>
 #include <limits>
 #include <sstream>
+#include <unordered_map>
 
 #include "hashmgr.hxx"
 #include "csutil.hxx"
 #include "atypes.hxx"
 
+#define ARENA_BLOCK_SIZE (256 * 1024)
+
+HashArena::~HashArena() {
+  for (size_t i = 0; i < blocks.size(); i++)
+    free(blocks[i]);
+}
+
+void* HashArena::alloc(size_t size, size_t alignment) {
+  size_t padding = (alignment - (uintptr_t)next % alignment) % alignment;
+  if (!next || padding + size > left) {
+    // large allocations get their own block, current one is kept
+    size_t block_size = std::max(size, (size_t)ARENA_BLOCK_SIZE);
+    char* block = (char*)malloc(block_size);
+    if (!block)
+      return NULL;
+    blocks.push_back(block);
+    if (block_size > ARENA_BLOCK_SIZE && next)
+      return block;
+    next = block;
+    left = block_size;
+    padding = 0;
+  }
+  char* p = next + padding;
+  next = p + size;
+  left -= padding + size;
+  return p;
+}
+
+size_t flag_vector_hash::operator()(const flag_vector& v) const {
+  size_t h = v.len;
+  for (int i = 0; i < v.len; i++)
+    h = h * 31 + v.flags[i];
+  return h;
+}
+
+bool flag_vector_equal::operator()(const flag_vector& a,
+                                   const flag_vector& b) const {
+  return a.len == b.len &&
+         memcmp(a.flags, b.flags, a.len * sizeof(unsigned short)) == 0;
+}
+
 // build a hash table from a munched word list
 
 HashMgr::HashMgr(const char* tpath, const char* apath, const char* key)
     : tablesize(0),
+      tablecount(0),
       tableptr(NULL),
+      fingerprints(NULL),
+      walkbuckets(0),
+      walkcount(0),
+      walkorder(NULL),
       flag_mode(FLAG_CHAR),
       complexprefixes(0),
       utf8(0),
@@ -93,43 +141,36 @@ HashMgr::HashMgr(const char* tpath, const char* apath, const char* key)
       aliasf(NULL),
       aliasflen(0),
       numaliasm(0),
-      aliasm(NULL) {
+      aliasm(NULL),
+      snapshot(NULL),
+      affix_snapshot(NULL),
+      affix_snapshot_size(0) {
   langnum = 0;
   csconv = 0;
+  // encrypted dictionaries are not stored in snapshots
+  if (!key)
+    snapshot = new DicSnapshot(apath, tpath);
+  // affix file settings are restored with the table
+  if (load_snapshot())
+    return;
   load_config(apath, key);
   int ec = load_tables(tpath, key);
   if (ec) {
     /* error condition - what should we do here */
     HUNSPELL_WARNING(stderr, "Hash Manager Error : %d\n", ec);
-    free(tableptr);
-    //keep tablesize to 1 to fix possible division with zero
-    tablesize = 1;
-    tableptr = (struct hentry**)calloc(tablesize, sizeof(struct hentry*));
-    if (!tableptr) {
-      tablesize = 0;
-    }
+    // entries added so far stay in the arena, the table is not saved
+    free_table();
+    alloc_table(1);
+    sort_walk_order(1);
+    delete snapshot;
+    snapshot = NULL;
   }
 }
 
 HashMgr::~HashMgr() {
-  if (tableptr) {
-    // now pass through hash table freeing up everything
-    // go through column by column of the table
-    for (int i = 0; i < tablesize; i++) {
-      struct hentry* pt = tableptr[i];
-      struct hentry* nt = NULL;
-      while (pt) {
-        nt = pt->next;
-        if (pt->astr &&
-            (!aliasf || TESTAFF(pt->astr, ONLYUPCASEFLAG, pt->alen)))
-          free(pt->astr);
-        free(pt);
-        pt = nt;
-      }
-    }
-    free(tableptr);
-  }
-  tablesize = 0;
+  // entries and flag vectors are freed with the arena or the snapshot
+  free_table();
+  delete snapshot;
 
   if (aliasf) {
     for (int j = 0; j < (numaliasf); j++)
@@ -163,23 +204,194 @@ HashMgr::~HashMgr() {
 // lookup a root word in the hashtable
 
 struct hentry* HashMgr::lookup(const char* word) const {
-  struct hentry* dp;
-  if (tableptr) {
-    dp = tableptr[hash(word)];
-    if (!dp)
-      return NULL;
-    for (; dp != NULL; dp = dp->next) {
-      if (strcmp(word, dp->word) == 0)
-        return dp;
-    }
+  if (!tablesize)
+    return NULL;
+  int i = find_slot(word, hash(word));
+  return i >= 0 ? tableptr[i] : NULL;
+}
+
+static unsigned short fingerprint(uint64_t hv) {
+  unsigned short fp = (unsigned short)(hv >> 48);
+  return fp ? fp : 1;
+}
+
+// returns slot of the word or the empty slot it would be stored in, -1 if
+// there is neither (only in a full table of a damaged snapshot)
+int HashMgr::find_slot(const char* word, uint64_t hv) const {
+  unsigned short fp = fingerprint(hv);
+  // low 32 bits of the hash are scaled to the table size
+  int i = (int)(((hv & 0xFFFFFFFF) * (uint64_t)tablesize) >> 32);
+  for (int probes = 0; probes < tablesize; probes++) {
+    if (!fingerprints[i] ||
+        (fingerprints[i] == fp && strcmp(word, tableptr[i]->word) == 0))
+      return i;
+    if (++i == tablesize)
+      i = 0;
   }
-  return NULL;
+  return -1;
+}
+
+bool HashMgr::alloc_table(int size) {
+  tableptr = (struct hentry**)calloc(size, sizeof(struct hentry*));
+  fingerprints = (unsigned short*)calloc(size, sizeof(unsigned short));
+  if (!tableptr || !fingerprints) {
+    free(tableptr);
+    free(fingerprints);
+    tableptr = NULL;
+    fingerprints = NULL;
+    tablesize = 0;
+    return false;
+  }
+  tablesize = size;
+  tablecount = 0;
+  return true;
+}
+
+// table of the snapshot is left in the mapping
+void HashMgr::free_table() {
+  if (!snapshot || !snapshot->contains(tableptr)) {
+    free(tableptr);
+    free(fingerprints);
+    free(walkorder);
+  }
+  tableptr = NULL;
+  fingerprints = NULL;
+  tablesize = 0;
+  tablecount = 0;
+  walkorder = NULL;
+  walkcount = 0;
+  walkadded.clear();
+}
+
+// hash function of the former chained table, only for walk order
+int HashMgr::walk_bucket(const char* word) const {
+  unsigned long hv = 0;
+  for (int i = 0; i < 4 && *word != 0; i++)
+    hv = (hv << 8) | (*word++);
+  while (*word != 0) {
+    ROTATE(hv, ROTATE_LEN);
+    hv ^= (*word++);
+  }
+  return (unsigned long)hv % walkbuckets;
+}
+
+// entries of the dic file (added in their order) are sorted by bucket,
+// keeping their order within a bucket
+bool HashMgr::sort_walk_order(int buckets) {
+  walkbuckets = buckets;
+  std::vector<int> offsets(buckets + 1, 0);
+  for (size_t i = 0; i < walkadded.size(); i++) {
+    walkadded[i].bucket = walk_bucket(walkadded[i].hp->word);
+    offsets[walkadded[i].bucket + 1]++;
+  }
+  for (int b = 0; b < buckets; b++)
+    offsets[b + 1] += offsets[b];
+  walkorder = (struct hentry**)malloc(
+      std::max(walkadded.size(), (size_t)1) * sizeof(struct hentry*));
+  if (!walkorder)
+    return false;
+  for (size_t i = 0; i < walkadded.size(); i++)
+    walkorder[offsets[walkadded[i].bucket]++] = walkadded[i].hp;
+  walkcount = (int)walkadded.size();
+  std::vector<walk_entry>().swap(walkadded);
+  return true;
+}
+
+void HashMgr::add_to_walk_order(struct hentry* hp) {
+  walk_entry entry = {0, 0, hp};
+  // entries of the dic file are sorted after loading
+  if (!walkbuckets) {
+    walkadded.push_back(entry);
+    return;
+  }
+  // after entries of the same bucket
+  entry.bucket = walk_bucket(hp->word);
+  int lo = 0, hi = walkcount;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (walk_bucket(walkorder[mid]->word) <= entry.bucket)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  entry.pos = lo;
+  size_t i = walkadded.size();
+  while (i > 0 && walkadded[i - 1].bucket > entry.bucket)
+    i--;
+  walkadded.insert(walkadded.begin() + i, entry);
+}
+
+// added entry j is at walk order position pos + j
+struct hentry* HashMgr::get_walk_entry(int pos) const {
+  if (walkadded.empty())
+    return walkorder[pos];
+  size_t lo = 0, hi = walkadded.size();
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (walkadded[mid].pos + (int)mid < pos)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo < walkadded.size() && walkadded[lo].pos + (int)lo == pos)
+    return walkadded[lo].hp;
+  return walkorder[pos - lo];
+}
+
+// table is doubled when it would be more than 3/4 full, e.g. after many
+// user words
+bool HashMgr::grow_table() {
+  int oldsize = tablesize;
+  struct hentry** oldtable = tableptr;
+  unsigned short* oldfingerprints = fingerprints;
+  bool oldmapped = snapshot && snapshot->contains(oldtable);
+  if (oldsize >= std::numeric_limits<int>::max() / 2 ||
+      !alloc_table(std::max(oldsize * 2, 16))) {
+    tablesize = oldsize;
+    tableptr = oldtable;
+    fingerprints = oldfingerprints;
+    return false;
+  }
+  for (int i = 0; i < oldsize; i++) {
+    if (!oldtable[i])
+      continue;
+    uint64_t hv = hash(oldtable[i]->word);
+    int j = find_slot(oldtable[i]->word, hv);
+    fingerprints[j] = fingerprint(hv);
+    tableptr[j] = oldtable[i];
+    tablecount++;
+  }
+  if (!oldmapped) {
+    free(oldtable);
+    free(oldfingerprints);
+  }
+  return true;
+}
+
+// flag vectors are immutable once interned, so they can be shared by entries
+unsigned short* HashMgr::intern_flags(const unsigned short* flags, int len) {
+  if (!flags || len <= 0)
+    return NULL;
+  flag_vector key = {flags, len};
+  std::unordered_set<flag_vector, flag_vector_hash,
+                     flag_vector_equal>::const_iterator it =
+      interned_flags.find(key);
+  if (it != interned_flags.end())
+    return (unsigned short*)it->flags;
+  unsigned short* copy = (unsigned short*)arena.alloc(
+      len * sizeof(unsigned short), sizeof(unsigned short));
+  if (!copy)
+    return NULL;
+  memcpy(copy, flags, len * sizeof(unsigned short));
+  key.flags = copy;
+  interned_flags.insert(key);
+  return copy;
 }
 
 // add a word to the hash table (private)
 int HashMgr::add_word(const std::string& in_word,
                       int wcl,
-                      unsigned short* aff,
+                      const unsigned short* aff,
                       int al,
                       const std::string* in_desc,
                       bool onlyupcase) {
@@ -221,11 +433,10 @@ int HashMgr::add_word(const std::string& in_word,
     word = word_copy;
   }
 
-  bool upcasehomonym = false;
   int descl = desc ? (aliasm ? sizeof(char*) : desc->size() + 1) : 0;
   // variable-length hash record with word and optional fields
-  struct hentry* hp =
-      (struct hentry*)malloc(sizeof(struct hentry) + word->size() + descl);
+  struct hentry* hp = (struct hentry*)arena.alloc(
+      sizeof(struct hentry) + word->size() + descl, sizeof(void*));
   if (!hp) {
     delete desc_copy;
     delete word_copy;
@@ -235,13 +446,10 @@ int HashMgr::add_word(const std::string& in_word,
   char* hpw = hp->word;
   strcpy(hpw, word->c_str());
 
-  int i = hash(hpw);
-
   hp->blen = (unsigned char)word->size();
   hp->clen = (unsigned char)wcl;
   hp->alen = (short)al;
-  hp->astr = aff;
-  hp->next = NULL;
+  hp->astr = intern_flags(aff, al);
   hp->next_homonym = NULL;
 
   // store the description string or its pointer
@@ -258,60 +466,42 @@ int HashMgr::add_word(const std::string& in_word,
   } else
     hp->var = 0;
 
+  // at least one slot is kept empty to stop probing
+  if (tablecount + 1 >= tablesize - tablesize / 4 && !grow_table()) {
+    delete desc_copy;
+    delete word_copy;
+    return 1;
+  }
+  uint64_t hv = hash(hpw);
+  int i = find_slot(hpw, hv);
+  if (i < 0) {
+    delete desc_copy;
+    delete word_copy;
+    return 1;
+  }
   struct hentry* dp = tableptr[i];
   if (!dp) {
+    fingerprints[i] = fingerprint(hv);
     tableptr[i] = hp;
+    tablecount++;
+    add_to_walk_order(hp);
     delete desc_copy;
     delete word_copy;
     return 0;
   }
-  while (dp->next != NULL) {
-    if ((!dp->next_homonym) && (strcmp(hp->word, dp->word) == 0)) {
-      // remove hidden onlyupcase homonym
-      if (!onlyupcase) {
-        if ((dp->astr) && TESTAFF(dp->astr, ONLYUPCASEFLAG, dp->alen)) {
-          free(dp->astr);
-          dp->astr = hp->astr;
-          dp->alen = hp->alen;
-          free(hp);
-          delete desc_copy;
-          delete word_copy;
-          return 0;
-        } else {
-          dp->next_homonym = hp;
-        }
-      } else {
-        upcasehomonym = true;
-      }
-    }
-    dp = dp->next;
-  }
-  if (strcmp(hp->word, dp->word) == 0) {
-    // remove hidden onlyupcase homonym
-    if (!onlyupcase) {
-      if ((dp->astr) && TESTAFF(dp->astr, ONLYUPCASEFLAG, dp->alen)) {
-        free(dp->astr);
-        dp->astr = hp->astr;
-        dp->alen = hp->alen;
-        free(hp);
-        delete desc_copy;
-        delete word_copy;
-        return 0;
-      } else {
-        dp->next_homonym = hp;
-      }
+  while (dp->next_homonym)
+    dp = dp->next_homonym;
+  // remove hidden onlyupcase homonym
+  if (!onlyupcase) {
+    if ((dp->astr) && TESTAFF(dp->astr, ONLYUPCASEFLAG, dp->alen)) {
+      // unused hp stays in the arena
+      dp->astr = hp->astr;
+      dp->alen = hp->alen;
     } else {
-      upcasehomonym = true;
+      dp->next_homonym = hp;
+      add_to_walk_order(hp);
     }
   }
-  if (!upcasehomonym) {
-    dp->next = hp;
-  } else {
-    // remove hidden onlyupcase homonym
-    if (hp->astr)
-      free(hp->astr);
-    free(hp);
-  }
 
   delete desc_copy;
   delete word_copy;
@@ -320,7 +510,7 @@ int HashMgr::add_word(const std::string& in_word,
 
 int HashMgr::add_hidden_capitalized_word(const std::string& word,
                                          int wcl,
-                                         unsigned short* flags,
+                                         const unsigned short* flags,
                                          int flagslen,
                                          const std::string* dp,
                                          int captype) {
@@ -333,13 +523,8 @@ int HashMgr::add_hidden_capitalized_word(const std::string& word,
   if (((captype == HUHCAP) || (captype == HUHINITCAP) ||
        ((captype == ALLCAP) && (flagslen != 0))) &&
       !((flagslen != 0) && TESTAFF(flags, forbiddenword, flagslen))) {
-    unsigned short* flags2 =
-        (unsigned short*)malloc(sizeof(unsigned short) * (flagslen + 1));
-    if (!flags2)
-      return 1;
-    if (flagslen)
-      memcpy(flags2, flags, flagslen * sizeof(unsigned short));
-    flags2[flagslen] = ONLYUPCASEFLAG;
+    std::vector<unsigned short> flags2(flags, flags + flagslen);
+    flags2.push_back(ONLYUPCASEFLAG);
     if (utf8) {
       std::string st;
       std::vector<w_char> w;
@@ -347,12 +532,12 @@ int HashMgr::add_hidden_capitalized_word(const std::string& word,
       mkallsmall_utf(w, langnum);
       mkinitcap_utf(w, langnum);
       u16_u8(st, w);
-      return add_word(st, wcl, flags2, flagslen + 1, dp, true);
+      return add_word(st, wcl, &flags2[0], flagslen + 1, dp, true);
     } else {
       std::string new_word(word);
       mkallsmall(new_word, csconv);
       mkinitcap(new_word, csconv);
-      int ret = add_word(new_word, wcl, flags2, flagslen + 1, dp, true);
+      int ret = add_word(new_word, wcl, &flags2[0], flagslen + 1, dp, true);
       return ret;
     }
   }
@@ -382,17 +567,14 @@ int HashMgr::remove(const std::string& word) {
   struct hentry* dp = lookup(word.c_str());
   while (dp) {
     if (dp->alen == 0 || !TESTAFF(dp->astr, forbiddenword, dp->alen)) {
-      unsigned short* flags =
-          (unsigned short*)malloc(sizeof(unsigned short) * (dp->alen + 1));
-      if (!flags)
+      std::vector<unsigned short> flags(dp->astr, dp->astr + dp->alen);
+      flags.push_back(forbiddenword);
+      std::sort(flags.begin(), flags.end());
+      unsigned short* interned = intern_flags(&flags[0], flags.size());
+      if (!interned)
         return 1;
-      for (int i = 0; i < dp->alen; i++)
-        flags[i] = dp->astr[i];
-      flags[dp->alen] = forbiddenword;
-      free(dp->astr);
-      dp->astr = flags;
+      dp->astr = interned;
       dp->alen++;
-      std::sort(flags, flags + dp->alen);
     }
     dp = dp->next_homonym;
   }
@@ -409,18 +591,21 @@ int HashMgr::remove_forbidden_flag(const std::string& word) {
       if (dp->alen == 1)
         dp->alen = 0;  // XXX forbidden words of personal dic.
       else {
-        unsigned short* flags2 =
-            (unsigned short*)malloc(sizeof(unsigned short) * (dp->alen - 1));
-        if (!flags2)
-          return 1;
-        int i, j = 0;
-        for (i = 0; i < dp->alen; i++) {
+        std::vector<unsigned short> flags2;
+        for (int i = 0; i < dp->alen; i++) {
           if (dp->astr[i] != forbiddenword)
-            flags2[j++] = dp->astr[i];
+            flags2.push_back(dp->astr[i]);
+        }
+        // the forbidden flag may be repeated in the vector
+        if (flags2.empty()) {
+          dp->alen = 0;
+        } else {
+          unsigned short* interned = intern_flags(&flags2[0], flags2.size());
+          if (!interned)
+            return 1;
+          dp->alen = (short)flags2.size();
+          dp->astr = interned;  // XXX allowed forbidden words
         }
-        dp->alen--;
-        free(dp->astr);
-        dp->astr = flags2;  // XXX allowed forbidden words
       }
     }
     dp = dp->next_homonym;
@@ -433,7 +618,7 @@ int HashMgr::add(const std::string& word) {
   if (remove_forbidden_flag(word)) {
     int captype;
     int al = 0;
-    unsigned short* flags = NULL;
+    const unsigned short* flags = NULL;
     int wcl = get_clen_and_captype(word, &captype);
     add_word(word, wcl, flags, al, NULL, false);
     return add_hidden_capitalized_word(word, wcl, flags, al, NULL,
@@ -449,18 +634,7 @@ int HashMgr::add_with_affix(const std::string& word, const std::string& example)
   if (dp && dp->astr) {
     int captype;
     int wcl = get_clen_and_captype(word, &captype);
-    if (aliasf) {
-      add_word(word, wcl, dp->astr, dp->alen, NULL, false);
-    } else {
-      unsigned short* flags =
-          (unsigned short*)malloc(dp->alen * sizeof(unsigned short));
-      if (flags) {
-        memcpy((void*)flags, (void*)dp->astr,
-               dp->alen * sizeof(unsigned short));
-        add_word(word, wcl, flags, dp->alen, NULL, false);
-      } else
-        return 1;
-    }
+    add_word(word, wcl, dp->astr, dp->alen, NULL, false);
     return add_hidden_capitalized_word(word, wcl, dp->astr,
                                        dp->alen, NULL, captype);
   }
@@ -469,18 +643,133 @@ int HashMgr::add_with_affix(const std::string& word, const std::string& example)
 
 // walk the hash table entry by entry - null at end
 // initialize: col=-1; hp = NULL; hp = walk_hashtable(&col, hp);
-struct hentry* HashMgr::walk_hashtable(int& col, struct hentry* hp) const {
-  if (hp && hp->next != NULL)
-    return hp->next;
-  for (col++; col < tablesize; col++) {
-    if (tableptr[col])
-      return tableptr[col];
-  }
+struct hentry* HashMgr::walk_hashtable(int& col, struct hentry*) const {
+  if (++col < get_walk_size())
+    return get_walk_entry(col);
   // null at end and reset to start
   col = -1;
   return NULL;
 }
 
+// adds bigrams of the lowercase word to keys, returns its signature
+uint64_t HashMgr::add_bigrams(std::vector<unsigned int>& keys,
+                              const std::string& word,
+                              std::vector<w_char>& wbuf,
+                              std::string& buf) const {
+  // same lowering as of roots in SuggestMgr::ngsuggest()
+  uint32_t chars = 0;
+  size_t len;
+  if (utf8) {
+    u8_u16(wbuf, word);
+    mkallsmall_utf(wbuf, langnum);
+    len = wbuf.size();
+    for (size_t i = 0; i < len; i++) {
+      unsigned short c = (wbuf[i].h << 8) + wbuf[i].l;
+      chars |= SIGNATURE_CHAR_BIT(c);
+      if (i > 0)
+        keys.push_back(
+            bigram_key((wbuf[i - 1].h << 8) + wbuf[i - 1].l, c));
+    }
+  } else {
+    buf.assign(word);
+    mkallsmall(buf, csconv);
+    len = buf.size();
+    for (size_t i = 0; i < len; i++) {
+      chars |= SIGNATURE_CHAR_BIT((unsigned char)buf[i]);
+      if (i > 0)
+        keys.push_back(
+            bigram_key((unsigned char)buf[i - 1], (unsigned char)buf[i]));
+    }
+  }
+  return chars | ((uint64_t)(len < 256 ? len : 0) << 32);
+}
+
+void HashMgr::build_bigram_index() {
+  bigram_ranges.clear();
+  bigram_positions.clear();
+  walk_signatures.assign(walkcount, 0);
+
+  // distinct bigrams of each entry, then grouped by bigram
+  std::vector<unsigned int> keys;
+  std::vector<size_t> ends;
+  std::vector<w_char> wbuf;
+  std::string buf, field;
+  for (int i = 0; i < walkcount; i++) {
+    struct hentry* hp = walkorder[i];
+    size_t start = keys.size();
+    uint64_t signature = add_bigrams(keys, hp->word, wbuf, buf);
+    if ((hp->var & H_OPT_PHON) &&
+        copy_field(field, HENTRY_DATA(hp), MORPH_PHON))
+      // length of the entry is unknown with the other word
+      signature = SIGNATURE_CHARS(signature) |
+                  SIGNATURE_CHARS(add_bigrams(keys, field, wbuf, buf));
+    walk_signatures[i] = signature;
+    std::sort(keys.begin() + start, keys.end());
+    keys.erase(std::unique(keys.begin() + start, keys.end()), keys.end());
+    ends.push_back(keys.size());
+  }
+  for (size_t i = 0; i < keys.size(); i++)
+    bigram_ranges[keys[i]].second++;
+  int offset = 0;
+  for (std::unordered_map<unsigned int, std::pair<int, int> >::iterator it =
+           bigram_ranges.begin();
+       it != bigram_ranges.end(); ++it) {
+    int count = it->second.second;
+    it->second.first = it->second.second = offset;
+    offset += count;
+  }
+  bigram_positions.resize(keys.size());
+  size_t start = 0;
+  for (size_t i = 0; i < ends.size(); i++) {
+    for (size_t j = start; j < ends[i]; j++)
+      bigram_positions[bigram_ranges[keys[j]].second++] = (int)i;
+    start = ends[i];
+  }
+}
+
+void HashMgr::match_bigrams(const std::vector<unsigned int>& bigrams,
+                            std::vector<uint64_t>& positions,
+                            std::vector<uint64_t>& signatures) {
+  std::call_once(bigram_index_built, &HashMgr::build_bigram_index, this);
+  int size = get_walk_size();
+  positions.assign(size, 0);
+  signatures.assign(walk_signatures.begin(), walk_signatures.end());
+  signatures.resize(size);
+
+  size_t count = std::min(bigrams.size(), (size_t)64);
+  for (size_t i = 0; i < count; i++) {
+    // all positions of a repeated bigram are set at its first one
+    if (std::find(bigrams.begin(), bigrams.begin() + i, bigrams[i]) !=
+        bigrams.begin() + i)
+      continue;
+    uint64_t bits = 0;
+    for (size_t j = i; j < count; j++) {
+      if (bigrams[j] == bigrams[i])
+        bits |= (uint64_t)1 << j;
+    }
+    std::unordered_map<unsigned int, std::pair<int, int> >::const_iterator it =
+        bigram_ranges.find(bigrams[i]);
+    if (it == bigram_ranges.end())
+      continue;
+    for (int k = it->second.first; k < it->second.second; k++)
+      positions[bigram_positions[k]] |= bits;
+  }
+  // dic file entries are moved apart for the added ones from the end
+  int i = walkcount - 1;
+  int j = (int)walkadded.size() - 1;
+  for (int pos = size - 1; j >= 0; pos--) {
+    if (walkadded[j].pos + j == pos) {
+      positions[pos] = ~(uint64_t)0;
+      signatures[pos] = 0xFFFFFFFF;
+      j--;
+    } else {
+      positions[pos] = positions[i];
+      signatures[pos] = signatures[i];
+      i--;
+    }
+  }
+}
+
 // load a munched word list and build a hash table on the fly
 int HashMgr::load_tables(const char* tpath, const char* key) {
   // open dictionary file
@@ -502,25 +791,22 @@ int HashMgr::load_tables(const char* tpath, const char* key) {
     ts.erase(0, 3);
   }
 
-  tablesize = atoi(ts.c_str());
+  int nwords = atoi(ts.c_str());
 
   int nExtra = 5 + USERWORD;
 
-  if (tablesize <= 0 ||
-      (tablesize >= (std::numeric_limits<int>::max() - 1 - nExtra) /
-                        int(sizeof(struct hentry*)))) {
+  if (nwords <= 0 ||
+      (nwords >= (std::numeric_limits<int>::max() - 1 - nExtra) /
+                     int(sizeof(struct hentry*)))) {
     HUNSPELL_WARNING(
         stderr, "error: line 1: missing or bad word count in the dic file\n");
     delete dict;
     return 4;
   }
-  tablesize += nExtra;
-  if ((tablesize % 2) == 0)
-    tablesize++;
 
-  // allocate the hash table
-  tableptr = (struct hentry**)calloc(tablesize, sizeof(struct hentry*));
-  if (!tableptr) {
+  // allocate the hash table, 2/3 full with the declared number of words,
+  // hidden capitalized forms are added beyond it
+  if (!alloc_table((nwords + nExtra) / 2 * 3 + 4)) {
     delete dict;
     return 3;
   }
@@ -605,28 +891,305 @@ int HashMgr::load_tables(const char* tpath, const char* key) {
     int wcl = get_clen_and_captype(ts, &captype, workbuf);
     const std::string *dp_str = dp.empty() ? NULL : &dp;
     // add the word and its index plus its capitalized form optionally
-    if (add_word(ts, wcl, flags, al, dp_str, false) ||
-        add_hidden_capitalized_word(ts, wcl, flags, al, dp_str, captype)) {
+    // flags are copied into interned vectors
+    int ret = add_word(ts, wcl, flags, al, dp_str, false) ||
+              add_hidden_capitalized_word(ts, wcl, flags, al, dp_str, captype);
+    if (!aliasf)
+      free(flags);
+    if (ret) {
       delete dict;
       return 5;
     }
   }
 
   delete dict;
-  return 0;
+  // walk order follows the former table, which had a bucket for each
+  // declared word
+  int buckets = nwords + nExtra;
+  if ((buckets % 2) == 0)
+    buckets++;
+  return sort_walk_order(buckets) ? 0 : 3;
 }
 
-// the hash function is a simple load and rotate
-// algorithm borrowed
-int HashMgr::hash(const char* word) const {
-  unsigned long hv = 0;
-  for (int i = 0; i < 4 && *word != 0; i++)
-    hv = (hv << 8) | (*word++);
+static size_t entry_size(const struct hentry* hp) {
+  size_t size = sizeof(struct hentry) + hp->blen;
+  if (hp->var & H_OPT_ALIASM)
+    size += sizeof(char*);
+  else if (hp->var & H_OPT)
+    size += strlen(HENTRY_WORD(hp) + hp->blen + 1) + 1;
+  return size;
+}
+
+static size_t align_offset(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+static T* relocate(T* p, uintptr_t delta) {
+  return p ? (T*)((uintptr_t)p + delta) : NULL;
+}
+
+// snapshot image: table size, number of used slots, walk order size and
+// buckets, offset and size of settings, slot entries, fingerprints, walk
+// order, then homonym chains, then interned flag vectors and morphological
+// aliases, then settings, all pointers are laid out for preferred base address
+// of the snapshot
+void HashMgr::save_snapshot(const std::vector<char>& affix_config) const {
+  if (!snapshot)
+    return;
+
+  // flag vectors and morphological aliases are shared between entries
+  std::unordered_map<const void*, size_t> shared_offsets;
+  std::unordered_map<const void*, size_t> shared_sizes;
+  for (std::unordered_set<flag_vector, flag_vector_hash,
+                          flag_vector_equal>::const_iterator it =
+           interned_flags.begin();
+       it != interned_flags.end(); ++it)
+    shared_sizes[it->flags] = it->len * sizeof(unsigned short);
+  for (int i = 0; i < numaliasm; i++)
+    shared_sizes[aliasm[i]] = strlen(aliasm[i]) + 1;
+
+  size_t table_offset = 6 * sizeof(uint64_t);
+  size_t fingerprints_offset =
+      table_offset + tablesize * sizeof(struct hentry*);
+  size_t walk_offset = align_offset(
+      fingerprints_offset + tablesize * sizeof(unsigned short),
+      sizeof(void*));
+  std::vector<char> image(walk_offset + walkcount * sizeof(struct hentry*));
+  if (tablesize)
+    memcpy(&image[fingerprints_offset], fingerprints,
+           tablesize * sizeof(unsigned short));
+  uint64_t base = snapshot->preferred_base();
+  std::vector<std::pair<size_t, const void*> > shared_refs;
+  std::unordered_map<const struct hentry*, size_t> entry_offsets;
+  for (int i = 0; i < tablesize; i++) {
+    // homonyms follow each other
+    size_t prev_offset = table_offset + i * sizeof(struct hentry*);
+    for (struct hentry* hp = tableptr[i]; hp; hp = hp->next_homonym) {
+      size_t offset = align_offset(image.size(), sizeof(void*));
+      image.resize(offset + entry_size(hp));
+      memcpy(&image[offset], hp, entry_size(hp));
+      entry_offsets[hp] = offset;
+      struct hentry* address = (struct hentry*)(uintptr_t)(base + offset);
+      memcpy(&image[prev_offset], &address, sizeof(address));
+      prev_offset = offset + offsetof(struct hentry, next_homonym);
+      if (hp->astr)
+        shared_refs.push_back(
+            std::make_pair(offset + offsetof(struct hentry, astr),
+                           (const void*)hp->astr));
+      if ((hp->var & H_OPT_ALIASM) && HENTRY_DATA(hp))
+        shared_refs.push_back(
+            std::make_pair(offset + offsetof(struct hentry, word) + hp->blen + 1,
+                           (const void*)HENTRY_DATA(hp)));
+    }
+  }
+  for (int i = 0; i < walkcount; i++) {
+    struct hentry* address =
+        (struct hentry*)(uintptr_t)(base + entry_offsets[walkorder[i]]);
+    memcpy(&image[walk_offset + i * sizeof(struct hentry*)], &address,
+           sizeof(address));
+  }
+
+  for (size_t i = 0; i < shared_refs.size(); i++) {
+    const void* shared = shared_refs[i].second;
+    std::unordered_map<const void*, size_t>::iterator it =
+        shared_offsets.find(shared);
+    if (it == shared_offsets.end()) {
+      size_t offset = align_offset(image.size(), sizeof(unsigned short));
+      size_t shared_size = shared_sizes[shared];
+      image.resize(offset + shared_size);
+      memcpy(&image[offset], shared, shared_size);
+      it = shared_offsets.insert(std::make_pair(shared, offset)).first;
+    }
+    char* address = (char*)(uintptr_t)(base + it->second);
+    // morphological alias pointer is stored unaligned
+    memcpy(&image[shared_refs[i].first], &address, sizeof(address));
+  }
+
+  size_t config_offset = align_offset(image.size(), sizeof(uint64_t));
+  image.resize(config_offset);
+  SnapshotWriter out(image);
+  out.put_vector(affix_config);
+  save_config(out);
+  uint64_t header[6] = {(uint64_t)tablesize,     (uint64_t)tablecount,
+                        (uint64_t)walkcount,     (uint64_t)walkbuckets,
+                        (uint64_t)config_offset,
+                        (uint64_t)(image.size() - config_offset)};
+  memcpy(&image[0], header, sizeof(header));
+  snapshot->save(image);
+}
+
+// entries have to be within the image, so a damaged snapshot can't make
+// lookups read outside of it
+static bool in_image(const void* p,
+                     size_t size,
+                     size_t alignment,
+                     const char* image,
+                     size_t image_size) {
+  uintptr_t offset = (uintptr_t)p - (uintptr_t)image;
+  return (uintptr_t)p >= (uintptr_t)image && offset <= image_size &&
+         size <= image_size - offset && offset % alignment == 0;
+}
+
+static bool string_in_image(const char* p,
+                            const char* image,
+                            size_t image_size) {
+  return in_image(p, 0, 1, image, image_size) &&
+         memchr(p, 0, image + image_size - p) != NULL;
+}
+
+// relocates pointers of the entry by delta and checks that the entry and
+// everything it points to are within the image, visited marks entries seen
+// before, so homonym chains can't be shared or cyclic
+static bool restore_entry(struct hentry* hp,
+                          uintptr_t delta,
+                          const char* image,
+                          size_t image_size,
+                          std::vector<bool>& visited) {
+  if (!in_image(hp, sizeof(struct hentry), sizeof(void*), image, image_size))
+    return false;
+  size_t index = ((const char*)hp - image) / sizeof(void*);
+  if (visited[index] ||
+      !in_image(hp, sizeof(struct hentry) + hp->blen, 1, image, image_size) ||
+      hp->word[hp->blen] != '\0' || hp->alen < 0)
+    return false;
+  visited[index] = true;
+  unsigned short* astr = relocate(hp->astr, delta);
+  if (astr && !in_image(astr, hp->alen * sizeof(unsigned short),
+                        sizeof(unsigned short), image, image_size))
+    return false;
+  char* data = HENTRY_WORD(hp) + hp->blen + 1;
+  if (hp->var & H_OPT_ALIASM) {
+    if (!in_image(data, sizeof(char*), 1, image, image_size))
+      return false;
+    char* alias = relocate(get_stored_pointer(data), delta);
+    if (alias && !string_in_image(alias, image, image_size))
+      return false;
+    if (delta)
+      store_pointer(data, alias);
+  } else if ((hp->var & H_OPT) && !string_in_image(data, image, image_size)) {
+    return false;
+  }
+  if (delta) {
+    hp->astr = astr;
+    hp->next_homonym = relocate(hp->next_homonym, delta);
+  }
+  return true;
+}
+
+bool HashMgr::load_snapshot() {
+  if (!snapshot)
+    return false;
+  uint64_t image_base;
+  size_t image_size;
+  char* image = snapshot->map(image_base, image_size);
+  if (!image)
+    return false;
+  // image couldn't be mapped at its preferred address, so all pointers
+  // are adjusted (and pages become private)
+  if (!restore_snapshot(image, image_size,
+                        (uintptr_t)image - (uintptr_t)image_base)) {
+    snapshot->unmap();
+    return false;
+  }
+  return true;
+}
+
+// nothing is changed unless the whole image is valid
+bool HashMgr::restore_snapshot(char* image,
+                               size_t image_size,
+                               uintptr_t delta) {
+  uint64_t header[6];
+  if (image_size < sizeof(header))
+    return false;
+  memcpy(header, image, sizeof(header));
+  // probing needs an empty slot
+  if (header[0] == 0 || header[1] >= header[0] ||
+      header[0] >= (uint64_t)std::numeric_limits<int>::max() ||
+      header[2] >= (uint64_t)std::numeric_limits<int>::max() ||
+      header[3] == 0 ||
+      header[3] >= (uint64_t)std::numeric_limits<int>::max() ||
+      header[0] >
+          image_size / (sizeof(struct hentry*) + sizeof(unsigned short)) ||
+      header[2] > image_size / sizeof(struct hentry*))
+    return false;
+  int size = (int)header[0];
+  int count = (int)header[1];
+  int walksize = (int)header[2];
+  size_t walk_offset = align_offset(
+      sizeof(header) + size * (sizeof(struct hentry*) + sizeof(unsigned short)),
+      sizeof(void*));
+  size_t config_offset = walk_offset + walksize * sizeof(struct hentry*);
+  if (config_offset > image_size || header[4] < config_offset ||
+      header[4] > image_size || header[5] > image_size - header[4])
+    return false;
+  struct hentry** table = (struct hentry**)(image + sizeof(header));
+  unsigned short* fps = (unsigned short*)(table + size);
+  struct hentry** walk = (struct hentry**)(image + walk_offset);
+
+  std::vector<bool> visited(image_size / sizeof(void*));
+  int used = 0;
+  for (int i = 0; i < size; i++) {
+    struct hentry* hp = relocate(table[i], delta);
+    if ((hp != NULL) != (fps[i] != 0))
+      return false;
+    if (delta)
+      table[i] = hp;
+    if (hp)
+      used++;
+    for (; hp; hp = hp->next_homonym) {
+      if (!restore_entry(hp, delta, image, image_size, visited))
+        return false;
+    }
+  }
+  if (used != count)
+    return false;
+  for (int i = 0; i < walksize; i++) {
+    struct hentry* hp = relocate(walk[i], delta);
+    if (!in_image(hp, sizeof(struct hentry), sizeof(void*), image,
+                  image_size) ||
+        !visited[((const char*)hp - image) / sizeof(void*)])
+      return false;
+    if (delta)
+      walk[i] = hp;
+  }
+
+  SnapshotReader in(image + header[4], (size_t)header[5]);
+  uint64_t affix_size;
+  const char* affix = NULL;
+  if (in.get_value(affix_size) && affix_size <= header[5])
+    affix = in.get_view((size_t)affix_size);
+  if (!affix || !load_config(in))
+    return false;
+  affix_snapshot = affix;
+  affix_snapshot_size = (size_t)affix_size;
+  tablesize = size;
+  tablecount = count;
+  walkcount = walksize;
+  walkbuckets = (int)header[3];
+  tableptr = table;
+  fingerprints = fps;
+  walkorder = walk;
+  return true;
+}
+
+const char* HashMgr::get_affix_snapshot(size_t& size) const {
+  size = affix_snapshot_size;
+  return affix_snapshot;
+}
+
+// FNV-1a with a final mix, so both slot index (low bits) and fingerprint
+// (high bits) depend on all characters
+uint64_t HashMgr::hash(const char* word) const {
+  uint64_t hv = 14695981039346656037ULL;
   while (*word != 0) {
-    ROTATE(hv, ROTATE_LEN);
-    hv ^= (*word++);
+    hv ^= (unsigned char)*word++;
+    hv *= 1099511628211ULL;
   }
-  return (unsigned long)hv % tablesize;
+  hv ^= hv >> 33;
+  hv *= 0xff51afd7ed558ccdULL;
+  hv ^= hv >> 33;
+  return hv;
 }
 
 int HashMgr::decode_flags(unsigned short** result, const std::string& flags, FileMgr* af) const {
@@ -951,6 +1514,128 @@ int HashMgr::load_config(const char* affpath, const char* key) {
   return 0;
 }
 
+// affix file settings read by load_config()
+void HashMgr::save_config(SnapshotWriter& out) const {
+  out.put_value((int)flag_mode);
+  out.put_value(complexprefixes);
+  out.put_value(utf8);
+  out.put_value(forbiddenword);
+  out.put_value(langnum);
+  out.put_string(enc);
+  out.put_string(lang);
+  out.put_string(ignorechars);
+  out.put_vector(ignorechars_utf16);
+  out.put_value(numaliasf);
+  for (int j = 0; j < numaliasf; j++) {
+    out.put_value(aliasflen[j]);
+    out.put_bytes(aliasf[j], aliasflen[j] * sizeof(unsigned short));
+  }
+  out.put_value(numaliasm);
+  for (int j = 0; j < numaliasm; j++)
+    out.put_string(aliasm[j]);
+}
+
+// settings stored by save_config(), nothing is changed on failure
+bool HashMgr::load_config(SnapshotReader& in) {
+  int mode, new_complexprefixes, new_utf8, new_langnum, new_numaliasf,
+      new_numaliasm;
+  unsigned short new_forbiddenword;
+  std::string new_enc, new_lang, new_ignorechars;
+  std::vector<w_char> new_ignorechars_utf16;
+  if (!in.get_value(mode) || mode < FLAG_CHAR || mode > FLAG_UNI ||
+      !in.get_value(new_complexprefixes) || !in.get_value(new_utf8) ||
+      !in.get_value(new_forbiddenword) || !in.get_value(new_langnum) ||
+      !in.get_string(new_enc) || !in.get_string(new_lang) ||
+      !in.get_string(new_ignorechars) ||
+      !in.get_vector(new_ignorechars_utf16) ||
+      !in.get_value(new_numaliasf) || new_numaliasf < 0)
+    return false;
+  std::vector<std::pair<const char*, unsigned short> > flag_aliases;
+  for (int j = 0; j < new_numaliasf; j++) {
+    unsigned short len;
+    const char* flags = NULL;
+    if (in.get_value(len))
+      flags = in.get_view(len * sizeof(unsigned short));
+    if (!flags)
+      return false;
+    flag_aliases.push_back(std::make_pair(flags, len));
+  }
+  if (!in.get_value(new_numaliasm) || new_numaliasm < 0)
+    return false;
+  std::vector<std::string> morph_aliases;
+  for (int j = 0; j < new_numaliasm; j++) {
+    std::string morph;
+    if (!in.get_string(morph))
+      return false;
+    morph_aliases.push_back(morph);
+  }
+
+  unsigned short** new_aliasf = NULL;
+  unsigned short* new_aliasflen = NULL;
+  char** new_aliasm = NULL;
+  if (new_numaliasf) {
+    new_aliasf =
+        (unsigned short**)calloc(new_numaliasf, sizeof(unsigned short*));
+    new_aliasflen =
+        (unsigned short*)calloc(new_numaliasf, sizeof(unsigned short));
+  }
+  if (new_numaliasm)
+    new_aliasm = (char**)calloc(new_numaliasm, sizeof(char*));
+  bool ok = (!new_numaliasf || (new_aliasf && new_aliasflen)) &&
+            (!new_numaliasm || new_aliasm);
+  for (int j = 0; ok && j < new_numaliasf; j++) {
+    size_t size = flag_aliases[j].second * sizeof(unsigned short);
+    new_aliasf[j] = (unsigned short*)malloc(size ? size : 1);
+    ok = new_aliasf[j] != NULL;
+    if (ok) {
+      memcpy(new_aliasf[j], flag_aliases[j].first, size);
+      new_aliasflen[j] = flag_aliases[j].second;
+    }
+  }
+  for (int j = 0; ok && j < new_numaliasm; j++) {
+    new_aliasm[j] = mystrdup(morph_aliases[j].c_str());
+    ok = new_aliasm[j] != NULL;
+  }
+  if (!ok) {
+    for (int j = 0; new_aliasf && j < new_numaliasf; j++)
+      free(new_aliasf[j]);
+    for (int j = 0; new_aliasm && j < new_numaliasm; j++)
+      free(new_aliasm[j]);
+    free(new_aliasf);
+    free(new_aliasflen);
+    free(new_aliasm);
+    return false;
+  }
+
+  flag_mode = (flag)mode;
+  complexprefixes = new_complexprefixes;
+  utf8 = new_utf8;
+  forbiddenword = new_forbiddenword;
+  langnum = new_langnum;
+  enc = new_enc;
+  lang = new_lang;
+  ignorechars = new_ignorechars;
+  ignorechars_utf16 = new_ignorechars_utf16;
+  numaliasf = new_numaliasf;
+  aliasf = new_aliasf;
+  aliasflen = new_aliasflen;
+  numaliasm = new_numaliasm;
+  aliasm = new_aliasm;
+  // as set by the SET line
+  if (utf8) {
+#ifndef OPENOFFICEORG
+#ifndef MOZILLA_CLIENT
+    initialize_utf_tbl();
+#endif
+#endif
+  } else if (!enc.empty()) {
+    csconv = get_current_cs(enc);
+  }
+  if (csconv == NULL)
+    csconv = get_current_cs(SPELL_ENCODING);
+  return true;
+}
+
 /* parse in the ALIAS table */
 bool HashMgr::parse_aliasf(const std::string& line, FileMgr* af) {
   if (numaliasf != 0) {
@@ -71,19 +71,87 @@
 #ifndef HASHMGR_HXX_
 #define HASHMGR_HXX_
 
+#include <stdint.h>
 #include <stdio.h>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "htypes.hxx"
 #include "filemgr.hxx"
 #include "w_char.hxx"
+#include "dicsnapshot.hxx"
 
 enum flag { FLAG_CHAR, FLAG_LONG, FLAG_NUM, FLAG_UNI };
 
+// bump allocator for hash entries and flag vectors, memory is released
+// only all at once
+class HashArena {
+  std::vector<char*> blocks;
+  char* next;
+  size_t left;
+
+ public:
+  HashArena() : next(NULL), left(0) {}
+  ~HashArena();
+  void* alloc(size_t size, size_t alignment);
+
+ private:
+  HashArena(const HashArena&);
+  HashArena& operator=(const HashArena&);
+};
+
+struct flag_vector {
+  const unsigned short* flags;
+  int len;
+};
+
+struct flag_vector_hash {
+  size_t operator()(const flag_vector& v) const;
+};
+
+struct flag_vector_equal {
+  bool operator()(const flag_vector& a, const flag_vector& b) const;
+};
+
+// characters are bytes or UTF-16 code units
+inline unsigned int bigram_key(unsigned short c1, unsigned short c2) {
+  return ((unsigned int)c1 << 16) | c2;
+}
+
+// signature of the lowercase word (and ph: field) of an entry: bit (c & 31) is
+// set for each character c, length in characters is above them (0 if unknown)
+#define SIGNATURE_CHAR_BIT(c) ((uint32_t)1 << ((c) & 31))
+#define SIGNATURE_CHARS(s) ((uint32_t)(s))
+#define SIGNATURE_LENGTH(s) ((int)((s) >> 32))
+
+// entry added after the dic file, placed before walk order entry pos
+struct walk_entry {
+  int bucket;
+  int pos;
+  struct hentry* hp;
+};
+
+// Hash table uses open addressing with linear probing, a slot holds the first
+// entry of a word, its homonyms are chained by next_homonym. 16-bit
+// fingerprints of slot words are stored in a separate array, so probing
+// rarely touches entries of other words.
+// walk_hashtable() keeps the order of the former chained table, which
+// decides between suggestions of the same score: entries by bucket of the
+// former hash function, then in the order they were added.
 class HashMgr {
-  int tablesize;
+  int tablesize;   // number of slots
+  int tablecount;  // number of used slots
   struct hentry** tableptr;
+  unsigned short* fingerprints;  // 0 marks empty slot
+  int walkbuckets;  // bucket count of the former table, 0 while loading
+  int walkcount;
+  struct hentry** walkorder;  // entries of the dic file in walk order
+  // entries added after the dic file in walk order (all entries in the order
+  // of adding while loading)
+  std::vector<walk_entry> walkadded;
   flag flag_mode;
   int complexprefixes;
   int utf8;
@@ -99,14 +167,39 @@ class HashMgr {
   unsigned short* aliasflen;
   int numaliasm;  // morphological desciption `compression' with aliases
   char** aliasm;
+  DicSnapshot* snapshot;  // hash table is stored in the snapshot if mapped
+  // affix manager settings stored with a mapped table
+  const char* affix_snapshot;
+  size_t affix_snapshot_size;
+  HashArena arena;
+  // entries share flag vectors, there are usually only a few thousands
+  // distinct ones even in the largest dictionaries
+  std::unordered_set<flag_vector, flag_vector_hash, flag_vector_equal>
+      interned_flags;
+  // walk order positions of dic file entries by bigrams of their lowercase
+  // words and ph: fields, and entry signatures, built on first use by n-gram
+  // suggestions (possibly of several threads at once), never changed later
+  std::once_flag bigram_index_built;
+  std::unordered_map<unsigned int, std::pair<int, int> > bigram_ranges;
+  std::vector<int> bigram_positions;
+  std::vector<uint64_t> walk_signatures;
 
  public:
   HashMgr(const char* tpath, const char* apath, const char* key = NULL);
   ~HashMgr();
 
   struct hentry* lookup(const char*) const;
-  int hash(const char*) const;
+  uint64_t hash(const char*) const;
   struct hentry* walk_hashtable(int& col, struct hentry* hp) const;
+  // entries in walk_hashtable() order
+  int get_walk_size() const { return walkcount + (int)walkadded.size(); }
+  struct hentry* get_walk_entry(int pos) const;
+  // for each walk order position, bit i of positions is set if bigram i of
+  // the word (at most 64) is in the lowercase entry, and signatures are set,
+  // entries added after the dic file match everything
+  void match_bigrams(const std::vector<unsigned int>& bigrams,
+                     std::vector<uint64_t>& positions,
+                     std::vector<uint64_t>& signatures);
 
   int add(const std::string& word);
   int add_with_affix(const std::string& word, const std::string& pattern);
@@ -119,27 +212,50 @@ class HashMgr {
   int get_aliasf(int index, unsigned short** fvec, FileMgr* af) const;
   int is_aliasm() const;
   char* get_aliasm(int index) const;
+  // affix manager settings stored with the table, NULL if the table was not
+  // loaded from a snapshot
+  const char* get_affix_snapshot(size_t& size) const;
+  // stores the table and affix file settings with affix manager settings
+  // for the next loads
+  void save_snapshot(const std::vector<char>& affix_config) const;
 
  private:
   int get_clen_and_captype(const std::string& word, int* captype);
   int get_clen_and_captype(const std::string& word, int* captype, std::vector<w_char> &workbuf);
   int load_tables(const char* tpath, const char* key);
+  bool alloc_table(int size);
+  bool grow_table();
+  void free_table();
+  int find_slot(const char* word, uint64_t hv) const;
+  int walk_bucket(const char* word) const;
+  bool sort_walk_order(int buckets);
+  void add_to_walk_order(struct hentry* hp);
+  void build_bigram_index();
+  uint64_t add_bigrams(std::vector<unsigned int>& keys,
+                       const std::string& word,
+                       std::vector<w_char>& wbuf,
+                       std::string& buf) const;
   int add_word(const std::string& word,
                int wcl,
-               unsigned short* ap,
+               const unsigned short* ap,
                int al,
                const std::string* desc,
                bool onlyupcase);
+  unsigned short* intern_flags(const unsigned short* flags, int len);
   int load_config(const char* affpath, const char* key);
   bool parse_aliasf(const std::string& line, FileMgr* af);
   int add_hidden_capitalized_word(const std::string& word,
                                   int wcl,
-                                  unsigned short* flags,
+                                  const unsigned short* flags,
                                   int al,
                                   const std::string* dp,
                                   int captype);
   bool parse_aliasm(const std::string& line, FileMgr* af);
   int remove_forbidden_flag(const std::string& word);
+  bool load_snapshot();
+  bool restore_snapshot(char* image, size_t image_size, uintptr_t delta);
+  void save_config(SnapshotWriter& out) const;
+  bool load_config(SnapshotReader& in);
 };
 
 #endif
@@ -99,6 +99,9 @@ public:
   bool input_conv(const std::string& word, std::string& dest);
   bool spell(const std::string& word, int* info = NULL, std::string* root = NULL);
   std::vector<std::string> suggest(const std::string& word);
+  std::vector<std::string> suggest(const std::string& word,
+                                   const suggest_limits& limits,
+                                   const suggest_tier_callback& fast_tier);
   const std::string& get_wordchars() const;
   const std::vector<w_char>& get_wordchars_utf16() const;
   const std::string& get_dict_encoding() const;
@@ -138,6 +141,17 @@ private:
   hentry*
   spellsharps(std::string& base, size_t start_pos, int, int, int* info, std::string* root);
   int is_keepcase(const hentry* rv);
+  std::vector<std::string> suggest_internal(
+      const std::string& word,
+      const suggest_limits& limits,
+      const suggest_tier_callback& fast_tier);
+  void finish_suggest(std::vector<std::string>& slst,
+                      const std::string& word,
+                      const std::string& scw,
+                      int captype,
+                      int capwords,
+                      size_t abbv,
+                      const suggest_limits& limits);
   void insert_sug(std::vector<std::string>& slst, const std::string& word);
   void cat_result(std::string& result, const std::string& st);
   std::vector<std::string> spellml(const std::string& word);
@@ -165,7 +179,13 @@ HunspellImpl::HunspellImpl(const char* affpath, const char* dpath, const char* k
 
   /* next set up the affix manager */
   /* it needs access to the hash manager lookup methods */
-  pAMgr = new AffixMgr(affpath, m_HMgrs, key);
+  /* parsed affix file is stored in the dictionary snapshot */
+  pAMgr = new AffixMgr(m_HMgrs);
+  if (!pAMgr->load_snapshot()) {
+    delete pAMgr;
+    pAMgr = new AffixMgr(affpath, m_HMgrs, key);
+    pAMgr->save_snapshot(m_HMgrs[0]);
+  }
 
   /* get the preferred try string and the dictionary */
   /* encoding from the Affix Manager for that dictionary */
@@ -216,7 +236,11 @@ int Hunspell::add_dic(const char* dpath, const char* key) {
 int HunspellImpl::add_dic(const char* dpath, const char* key) {
   if (!affixpath)
     return 1;
-  m_HMgrs.push_back(new HashMgr(dpath, affixpath, key));
+  HashMgr* pHMgr = new HashMgr(dpath, affixpath, key);
+  m_HMgrs.push_back(pHMgr);
+  size_t affix_size;
+  if (!pHMgr->get_affix_snapshot(affix_size))
+    pAMgr->save_snapshot(pHMgr);
   return 0;
 }
 
@@ -829,7 +853,35 @@ std::vector<std::string> Hunspell::suggest(const std::string& word) {
   return m_Impl->suggest(word);
 }
 
+std::vector<std::string> Hunspell::suggest(
+    const std::string& word,
+    const suggest_limits& limits,
+    const suggest_tier_callback& fast_tier) {
+  return m_Impl->suggest(word, limits, fast_tier);
+}
+
 std::vector<std::string> HunspellImpl::suggest(const std::string& word) {
+  return suggest(word, suggest_limits(), suggest_tier_callback());
+}
+
+std::vector<std::string> HunspellImpl::suggest(
+    const std::string& word,
+    const suggest_limits& limits,
+    const suggest_tier_callback& fast_tier) {
+  if (!pSMgr)
+    return std::vector<std::string>();
+  std::vector<std::string> slst = suggest_internal(word, limits, fast_tier);
+  // cut only after the last recasing and filtering, which may reorder and
+  // remove suggestions
+  if (limits.max_count && slst.size() > limits.max_count)
+    slst.resize(limits.max_count);
+  return slst;
+}
+
+std::vector<std::string> HunspellImpl::suggest_internal(
+    const std::string& word,
+    const suggest_limits& limits,
+    const suggest_tier_callback& fast_tier) {
   std::vector<std::string> slst;
 
   int onlycmpdsug = 0;
@@ -884,22 +936,22 @@ std::vector<std::string> HunspellImpl::suggest(const std::string& word) {
 
   switch (captype) {
     case NOCAP: {
-      pSMgr->suggest(slst, scw.c_str(), &onlycmpdsug);
+      pSMgr->suggest(slst, scw.c_str(), &onlycmpdsug, limits);
       break;
     }
 
     case INITCAP: {
       capwords = 1;
-      pSMgr->suggest(slst, scw.c_str(), &onlycmpdsug);
+      pSMgr->suggest(slst, scw.c_str(), &onlycmpdsug, limits);
       std::string wspace(scw);
       mkallsmall2(wspace, sunicw);
-      pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug);
+      pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug, limits);
       break;
     }
     case HUHINITCAP:
       capwords = 1;
     case HUHCAP: {
-      pSMgr->suggest(slst, scw.c_str(), &onlycmpdsug);
+      pSMgr->suggest(slst, scw.c_str(), &onlycmpdsug, limits);
       // something.The -> something. The
       size_t dot_pos = scw.find('.');
       if (dot_pos != std::string::npos) {
@@ -925,19 +977,19 @@ std::vector<std::string> HunspellImpl::suggest(const std::string& word) {
         // TheOpenOffice.org -> The OpenOffice.org
         wspace = scw;
         mkinitsmall2(wspace, sunicw);
-        pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug);
+        pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug, limits);
       }
       wspace = scw;
       mkallsmall2(wspace, sunicw);
       if (spell(wspace.c_str()))
         insert_sug(slst, wspace);
       size_t prevns = slst.size();
-      pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug);
+      pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug, limits);
       if (captype == HUHINITCAP) {
         mkinitcap2(wspace, sunicw);
         if (spell(wspace.c_str()))
           insert_sug(slst, wspace);
-        pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug);
+        pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug, limits);
       }
       // aNew -> "a New" (instead of "a new")
       for (size_t j = prevns; j < slst.size(); ++j) {
@@ -964,11 +1016,11 @@ std::vector<std::string> HunspellImpl::suggest(const std::string& word) {
     case ALLCAP: {
       std::string wspace(scw);
       mkallsmall2(wspace, sunicw);
-      pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug);
+      pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug, limits);
       if (pAMgr && pAMgr->get_keepcase() && spell(wspace.c_str()))
         insert_sug(slst, wspace);
       mkinitcap2(wspace, sunicw);
-      pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug);
+      pSMgr->suggest(slst, wspace.c_str(), &onlycmpdsug, limits);
       for (size_t j = 0; j < slst.size(); ++j) {
         mkallcap(slst[j]);
         if (pAMgr && pAMgr->get_checksharps()) {
@@ -1003,9 +1055,16 @@ std::vector<std::string> HunspellImpl::suggest(const std::string& word) {
 
   // try ngram approach since found nothing or only compound words
   if (pAMgr && (slst.empty() || onlycmpdsug) && (pAMgr->get_maxngramsugs() != 0)) {
+    // edit-based suggestions are ready long before the ngram ones
+    if (fast_tier) {
+      std::vector<std::string> tier(slst);
+      finish_suggest(tier, word, scw, captype, capwords, abbv, limits);
+      fast_tier(tier);
+    }
+
     switch (captype) {
       case NOCAP: {
-        pSMgr->ngsuggest(slst, scw.c_str(), m_HMgrs);
+        pSMgr->ngsuggest(slst, scw.c_str(), m_HMgrs, limits);
         break;
       }
       case HUHINITCAP:
@@ -1013,21 +1072,21 @@ std::vector<std::string> HunspellImpl::suggest(const std::string& word) {
       case HUHCAP: {
         std::string wspace(scw);
         mkallsmall2(wspace, sunicw);
-        pSMgr->ngsuggest(slst, wspace.c_str(), m_HMgrs);
+        pSMgr->ngsuggest(slst, wspace.c_str(), m_HMgrs, limits);
         break;
       }
       case INITCAP: {
         capwords = 1;
         std::string wspace(scw);
         mkallsmall2(wspace, sunicw);
-        pSMgr->ngsuggest(slst, wspace.c_str(), m_HMgrs);
+        pSMgr->ngsuggest(slst, wspace.c_str(), m_HMgrs, limits);
         break;
       }
       case ALLCAP: {
         std::string wspace(scw);
         mkallsmall2(wspace, sunicw);
         size_t oldns = slst.size();
-        pSMgr->ngsuggest(slst, wspace.c_str(), m_HMgrs);
+        pSMgr->ngsuggest(slst, wspace.c_str(), m_HMgrs, limits);
         for (size_t j = oldns; j < slst.size(); ++j) {
           mkallcap(slst[j]);
         }
@@ -1036,6 +1095,19 @@ std::vector<std::string> HunspellImpl::suggest(const std::string& word) {
     }
   }
 
+  finish_suggest(slst, word, scw, captype, capwords, abbv, limits);
+  return slst;
+}
+
+// common steps of suggestion lists (dash suggestions, recasing, output
+// conversion etc.) after the suggestion search
+void HunspellImpl::finish_suggest(std::vector<std::string>& slst,
+                                  const std::string& word,
+                                  const std::string& scw,
+                                  int captype,
+                                  int capwords,
+                                  size_t abbv,
+                                  const suggest_limits& limits) {
   // try dash suggestion (Afo-American -> Afro-American)
   size_t dash_pos = scw.find('-');
   if (dash_pos != std::string::npos) {
@@ -1053,7 +1125,8 @@ std::vector<std::string> HunspellImpl::suggest(const std::string& word) {
         last = 1;
       std::string chunk = scw.substr(prev_pos, dash_pos - prev_pos);
       if (!spell(chunk.c_str())) {
-        std::vector<std::string> nlst = suggest(chunk.c_str());
+        std::vector<std::string> nlst =
+            suggest_internal(chunk, limits, suggest_tier_callback());
         for (std::vector<std::string>::reverse_iterator j = nlst.rbegin(); j != nlst.rend(); ++j) {
           std::string wspace = scw.substr(0, prev_pos);
           wspace.append(*j);
@@ -1148,15 +1221,13 @@ std::vector<std::string> HunspellImpl::suggest(const std::string& word) {
   slst.resize(l);
 
   // output conversion
-  rl = (pAMgr) ? pAMgr->get_oconvtable() : NULL;
+  RepList* rl = (pAMgr) ? pAMgr->get_oconvtable() : NULL;
   for (size_t j = 0; rl && j < slst.size(); ++j) {
     std::string wspace;
     if (rl->conv(slst[j], wspace)) {
       slst[j] = wspace;
     }
   }
-
-  return slst;
 }
 
 const std::string& Hunspell::get_dict_encoding() const {
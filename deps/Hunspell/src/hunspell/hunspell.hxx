@@ -140,6 +140,18 @@ class LIBHUNSPELL_DLL_EXPORTED Hunspell {
   std::vector<std::string> suggest(const std::string& word);
   H_DEPRECATED int suggest(char*** slst, const char* word);
 
+  /* suggest(word, limits, fast_tier) - suggest() within limits
+   * input: the (bad) word, wall-clock deadline, cancellation flag and
+   *   maximal number of suggestions of the request, fast_tier may be empty
+   * output: suggestions found until the deadline or cancellation, at most
+   *   the requested number of them: the first ones of the complete list;
+   *   if the slower ngram search is needed, fast_tier receives edit-based
+   *   suggestions before it starts
+   */
+  std::vector<std::string> suggest(const std::string& word,
+                                   const suggest_limits& limits,
+                                   const suggest_tier_callback& fast_tier);
+
   /* Suggest words from suffix rules
    * suffix_suggest(suggestions, root_word)
    * input: pointer to an array of strings pointer and the  word
@@ -172,6 +172,13 @@ int RepList::add(const std::string& in_pat1, const std::string& pat2) {
   return 0;
 }
 
+int RepList::append(const replentry& r) {
+  if (pos >= size)
+    return 1;
+  dat[pos++] = new replentry(r);
+  return 0;
+}
+
 bool RepList::conv(const std::string& in_word, std::string& dest) {
   dest.clear();
 
@@ -92,6 +92,9 @@ class RepList {
   ~RepList();
 
   int add(const std::string& pat1, const std::string& pat2);
+  // appends an entry of a list stored in order (e.g. in a snapshot)
+  int append(const replentry& r);
+  int count() const { return pos; }
   replentry* item(int n);
   int find(const char* word);
   std::string replace(const char* word, int n, bool atstart);
@@ -72,6 +72,10 @@
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <thread>
 
 #include "suggestmgr.hxx"
 #include "htypes.hxx"
@@ -79,6 +83,11 @@
 
 const w_char W_VLINE = {'\0', '|'};
 
+// candidate generator of SuggestMgr::suggest(), adds to the given list
+typedef std::function<void(std::vector<std::string>&)> suggest_strategy;
+typedef std::function<bool(size_t, std::vector<std::string>&)>
+    suggest_merge;
+
 SuggestMgr::SuggestMgr(const char* tryme, unsigned int maxn, AffixMgr* aptr) {
   // register affix manager and check in string of chars to
   // try when building candidate suggestions
@@ -154,7 +163,7 @@ void SuggestMgr::testsug(std::vector<std::string>& wlst,
                         const std::string& candidate,
                         int cpdsuggest,
                         int* timer,
-                        clock_t* timelimit) {
+                        const suggest_limits* timelimit) {
   int cwrd = 1;
   if (wlst.size() == maxSug)
     return;
@@ -169,12 +178,43 @@ void SuggestMgr::testsug(std::vector<std::string>& wlst,
   }
 }
 
+// Runs candidate generators of suggest(), each on a copy of the list, on
+// worker threads (the first one on the calling thread). Their results are
+// passed to merge in order until it returns false, on a single core the
+// remaining generators are not run then.
+static void run_strategies(const std::vector<suggest_strategy>& strategies,
+                           std::vector<std::string> slst,
+                           const suggest_merge& merge) {
+  std::vector<std::vector<std::string> > results(strategies.size(), slst);
+  if (std::thread::hardware_concurrency() < 2) {
+    for (size_t i = 0; i < strategies.size(); ++i) {
+      strategies[i](results[i]);
+      if (!merge(i, results[i]))
+        return;
+    }
+    return;
+  }
+  std::vector<std::future<void> > tasks;
+  for (size_t i = 1; i < strategies.size(); ++i)
+    tasks.push_back(std::async(std::launch::async, strategies[i],
+                               std::ref(results[i])));
+  if (!strategies.empty())
+    strategies[0](results[0]);
+  for (size_t i = 0; i < tasks.size(); ++i)
+    tasks[i].get();
+  for (size_t i = 0; i < strategies.size(); ++i) {
+    if (!merge(i, results[i]))
+      return;
+  }
+}
+
 // generate suggestions for a misspelled word
 //    pass in address of array of char * pointers
 // onlycompoundsug: probably bad suggestions (need for ngram sugs, too)
 void SuggestMgr::suggest(std::vector<std::string>& slst,
                         const char* w,
-                        int* onlycompoundsug) {
+                        int* onlycompoundsug,
+                        const suggest_limits& limits) {
   int nocompoundtwowords = 0;
   std::vector<w_char> word_utf;
   int wl = 0;
@@ -202,6 +242,10 @@ void SuggestMgr::suggest(std::vector<std::string>& slst,
 
   for (int cpdsuggest = 0; (cpdsuggest < 2) && (nocompoundtwowords == 0);
        cpdsuggest++) {
+    // keep what was found if the request is out of time or cancelled
+    if (limits.reached())
+      break;
+
     // limit compound suggestion
     if (cpdsuggest > 0)
       oldSug = slst.size();
@@ -214,88 +258,120 @@ void SuggestMgr::suggest(std::vector<std::string>& slst,
         capchars(slst, word, cpdsuggest);
     }
 
+    // Following strategies only test candidates of their own, so they run
+    // in parallel, each on a copy of the list. Their results are merged in
+    // this order, as if they ran one after another.
+    std::vector<suggest_strategy> strategies;
+
     // perhaps we made a typical fault of spelling
-    if ((slst.size() < maxSug) && (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
-      replchars(slst, word, cpdsuggest);
-    }
+    strategies.push_back([&](std::vector<std::string>& lst) {
+      replchars(lst, word, cpdsuggest);
+    });
 
     // perhaps we made chose the wrong char from a related set
-    if ((slst.size() < maxSug) &&
-        (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
-      mapchars(slst, word, cpdsuggest);
-    }
-
-    // only suggest compound words when no other suggestion
-    if ((cpdsuggest == 0) && (slst.size() > nsugorig))
-      nocompoundtwowords = 1;
+    strategies.push_back([&](std::vector<std::string>& lst) {
+      mapchars(lst, word, cpdsuggest, limits);
+    });
 
     // did we swap the order of chars by mistake
-    if ((slst.size() < maxSug) && (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
+    strategies.push_back([&](std::vector<std::string>& lst) {
       if (utf8)
-        swapchar_utf(slst, &word_utf[0], wl, cpdsuggest);
+        swapchar_utf(lst, &word_utf[0], wl, cpdsuggest);
       else
-        swapchar(slst, word, cpdsuggest);
-    }
+        swapchar(lst, word, cpdsuggest);
+    });
 
     // did we swap the order of non adjacent chars by mistake
-    if ((slst.size() < maxSug) && (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
+    strategies.push_back([&](std::vector<std::string>& lst) {
       if (utf8)
-        longswapchar_utf(slst, &word_utf[0], wl, cpdsuggest);
+        longswapchar_utf(lst, &word_utf[0], wl, cpdsuggest);
       else
-        longswapchar(slst, word, cpdsuggest);
-    }
+        longswapchar(lst, word, cpdsuggest);
+    });
 
     // did we just hit the wrong key in place of a good char (case and keyboard)
-    if ((slst.size() < maxSug) && (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
+    strategies.push_back([&](std::vector<std::string>& lst) {
       if (utf8)
-        badcharkey_utf(slst, &word_utf[0], wl, cpdsuggest);
+        badcharkey_utf(lst, &word_utf[0], wl, cpdsuggest);
       else
-        badcharkey(slst, word, cpdsuggest);
-    }
+        badcharkey(lst, word, cpdsuggest);
+    });
 
     // did we add a char that should not be there
-    if ((slst.size() < maxSug) && (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
+    strategies.push_back([&](std::vector<std::string>& lst) {
       if (utf8)
-        extrachar_utf(slst, &word_utf[0], wl, cpdsuggest);
+        extrachar_utf(lst, &word_utf[0], wl, cpdsuggest);
       else
-        extrachar(slst, word, cpdsuggest);
-    }
+        extrachar(lst, word, cpdsuggest);
+    });
 
     // did we forgot a char
-    if ((slst.size() < maxSug) && (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
+    strategies.push_back([&](std::vector<std::string>& lst) {
       if (utf8)
-        forgotchar_utf(slst, &word_utf[0], wl, cpdsuggest);
+        forgotchar_utf(lst, &word_utf[0], wl, cpdsuggest, limits);
       else
-        forgotchar(slst, word, cpdsuggest);
-    }
+        forgotchar(lst, word, cpdsuggest, limits);
+    });
 
     // did we move a char
-    if ((slst.size() < maxSug) && (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
+    strategies.push_back([&](std::vector<std::string>& lst) {
       if (utf8)
-        movechar_utf(slst, &word_utf[0], wl, cpdsuggest);
+        movechar_utf(lst, &word_utf[0], wl, cpdsuggest);
       else
-        movechar(slst, word, cpdsuggest);
-    }
+        movechar(lst, word, cpdsuggest);
+    });
 
     // did we just hit the wrong key in place of a good char
-    if ((slst.size() < maxSug) && (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
+    strategies.push_back([&](std::vector<std::string>& lst) {
       if (utf8)
-        badchar_utf(slst, &word_utf[0], wl, cpdsuggest);
+        badchar_utf(lst, &word_utf[0], wl, cpdsuggest, limits);
       else
-        badchar(slst, word, cpdsuggest);
-    }
+        badchar(lst, word, cpdsuggest, limits);
+    });
 
     // did we double two characters
-    if ((slst.size() < maxSug) && (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
+    strategies.push_back([&](std::vector<std::string>& lst) {
       if (utf8)
-        doubletwochars_utf(slst, &word_utf[0], wl, cpdsuggest);
+        doubletwochars_utf(lst, &word_utf[0], wl, cpdsuggest);
       else
-        doubletwochars(slst, word, cpdsuggest);
-    }
+        doubletwochars(lst, word, cpdsuggest);
+    });
+
+    size_t base = slst.size();
+    // list size after the strategies up to mapchars
+    size_t mapchars_size = base;
+    suggest_merge merge = [&](size_t i, std::vector<std::string>& result) {
+      if ((slst.size() < maxSug) &&
+          (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
+        if (slst.size() == base) {
+          // nothing added before, the strategy has seen the same list
+          slst.swap(result);
+        } else {
+          for (size_t j = base; j < result.size() && slst.size() < maxSug; ++j) {
+            if (std::find(slst.begin(), slst.end(), result[j]) == slst.end())
+              slst.push_back(result[j]);
+          }
+        }
+      }
+      if (i <= 1)
+        mapchars_size = slst.size();
+      // the rest is not needed when the list is full
+      return (slst.size() < maxSug) &&
+             (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs));
+    };
+    if ((slst.size() < maxSug) && (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs)) &&
+        !limits.reached())
+      run_strategies(strategies, slst, merge);
+
+    // only suggest compound words when no other suggestion (up to mapchars)
+    if ((cpdsuggest == 0) && (mapchars_size > nsugorig))
+      nocompoundtwowords = 1;
 
     // perhaps we forgot to hit space and two words ran together
+    // (after the others, its dash form depends on suggestions before it)
     if (!nosplitsugs && (slst.size() < maxSug) &&
-        (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs))) {
+        (!cpdsuggest || (slst.size() < oldSug + maxcpdsugs)) &&
+        !limits.reached()) {
       twowords(slst, word, cpdsuggest);
     }
 
@@ -329,9 +405,10 @@ void SuggestMgr::capchars(std::vector<std::string>& wlst,
 // suggestions for when chose the wrong char out of a related set
 int SuggestMgr::mapchars(std::vector<std::string>& wlst,
                          const char* word,
-                         int cpdsuggest) {
+                         int cpdsuggest,
+                         const suggest_limits& limits) {
   std::string candidate;
-  clock_t timelimit;
+  suggest_limits timelimit;
   int timer;
 
   int wl = strlen(word);
@@ -342,7 +419,7 @@ int SuggestMgr::mapchars(std::vector<std::string>& wlst,
   if (maptable.empty())
     return wlst.size();
 
-  timelimit = clock();
+  timelimit = start_timelimit(limits);
   timer = MINTIMER;
   return map_related(word, candidate, 0, wlst, cpdsuggest,
                      maptable, &timer, &timelimit);
@@ -355,7 +432,7 @@ int SuggestMgr::map_related(const char* word,
                             int cpdsuggest,
                             const std::vector<mapentry>& maptable,
                             int* timer,
-                            clock_t* timelimit) {
+                            const suggest_limits* timelimit) {
   if (*(word + wn) == '\0') {
     int cwrd = 1;
     for (size_t m = 0; m < wlst.size(); ++m) {
@@ -585,9 +662,10 @@ int SuggestMgr::badcharkey_utf(std::vector<std::string>& wlst,
 }
 
 // error is wrong char in place of correct one
-int SuggestMgr::badchar(std::vector<std::string>& wlst, const char* word, int cpdsuggest) {
+int SuggestMgr::badchar(std::vector<std::string>& wlst, const char* word, int cpdsuggest,
+                        const suggest_limits& limits) {
   std::string candidate(word);
-  clock_t timelimit = clock();
+  suggest_limits timelimit = start_timelimit(limits);
   int timer = MINTIMER;
   // swap out each char one by one and try all the tryme
   // chars in its place to see if that makes a good word
@@ -610,10 +688,11 @@ int SuggestMgr::badchar(std::vector<std::string>& wlst, const char* word, int cp
 int SuggestMgr::badchar_utf(std::vector<std::string>& wlst,
                             const w_char* word,
                             int wl,
-                            int cpdsuggest) {
+                            int cpdsuggest,
+                            const suggest_limits& limits) {
   std::vector<w_char> candidate_utf(word, word + wl);
   std::string candidate;
-  clock_t timelimit = clock();
+  suggest_limits timelimit = start_timelimit(limits);
   int timer = MINTIMER;
   // swap out each char one by one and try all the tryme
   // chars in its place to see if that makes a good word
@@ -675,9 +754,10 @@ int SuggestMgr::extrachar(std::vector<std::string>& wlst,
 // error is missing a letter it needs
 int SuggestMgr::forgotchar(std::vector<std::string>& wlst,
                            const char* word,
-                           int cpdsuggest) {
+                           int cpdsuggest,
+                           const suggest_limits& limits) {
   std::string candidate(word);
-  clock_t timelimit = clock();
+  suggest_limits timelimit = start_timelimit(limits);
   int timer = MINTIMER;
 
   // try inserting a tryme character before every letter (and the null
@@ -699,9 +779,10 @@ int SuggestMgr::forgotchar(std::vector<std::string>& wlst,
 int SuggestMgr::forgotchar_utf(std::vector<std::string>& wlst,
                                const w_char* word,
                                int wl,
-                               int cpdsuggest) {
+                               int cpdsuggest,
+                               const suggest_limits& limits) {
   std::vector<w_char> candidate_utf(word, word + wl);
-  clock_t timelimit = clock();
+  suggest_limits timelimit = start_timelimit(limits);
   int timer = MINTIMER;
 
   // try inserting a tryme character at the end of the word and before every
@@ -994,7 +1075,12 @@ int SuggestMgr::movechar_utf(std::vector<std::string>& wlst,
 // generate a set of suggestions for very poorly spelled words
 void SuggestMgr::ngsuggest(std::vector<std::string>& wlst,
                           const char* w,
-                          const std::vector<HashMgr*>& rHMgr) {
+                          const std::vector<HashMgr*>& rHMgr,
+                          const suggest_limits& limits) {
+  // a full list (e.g. of compound words) can't get ngram suggestions
+  if (wlst.size() >= maxSug)
+    return;
+
   int lval;
   int sc;
   int lp, lpphon;
@@ -1061,75 +1147,57 @@ void SuggestMgr::ngsuggest(std::vector<std::string>& wlst,
     target = phonet(candidate, *ph);  // XXX phonet() is 8-bit (nc, not n)
   }
 
-  FLAG forbiddenword = pAMgr ? pAMgr->get_forbiddenword() : FLAG_NULL;
-  FLAG nosuggest = pAMgr ? pAMgr->get_nosuggest() : FLAG_NULL;
-  FLAG nongramsuggest = pAMgr ? pAMgr->get_nongramsuggest() : FLAG_NULL;
-  FLAG onlyincompound = pAMgr ? pAMgr->get_onlyincompound() : FLAG_NULL;
-
   std::vector<w_char> w_word, w_target;
   if (utf8) {
     u8_u16(w_word, word);
     u8_u16(w_target, target);
   }
-  
+
+  // without phonetic scores, roots which can't get among the best are
+  // skipped with score bounds from the bigram index of each dictionary, it's
+  // built from roots lowered like below, so the word must not change by
+  // lowering
+  std::vector<unsigned int> bigrams;
+  bool use_index = !ph && !nonbmp;
+  if (use_index) {
+    if (utf8) {
+      std::vector<w_char> w_low(w_word);
+      mkallsmall_utf(w_low, langnum);
+      use_index = w_low == w_word;
+      for (size_t i = 1; i < w_word.size(); i++)
+        bigrams.push_back(
+            bigram_key((w_word[i - 1].h << 8) + w_word[i - 1].l,
+                       (w_word[i].h << 8) + w_word[i].l));
+    } else {
+      std::string low_word(word);
+      mkallsmall(low_word, csconv);
+      use_index = low_word == word;
+      for (size_t i = 1; i < low_word.size(); i++)
+        bigrams.push_back(bigram_key((unsigned char)word[i - 1],
+                                     (unsigned char)word[i]));
+    }
+  }
+
   std::string f;
   std::vector<w_char> w_f;
-  
-  for (size_t i = 0; i < rHMgr.size(); ++i) {
+  std::vector<int> bounds;
+  int scored = 0;
+
+  // on deadline or cancellation, roots scored so far are used
+  for (size_t i = 0; i < rHMgr.size() && !limits.reached(); ++i) {
+    bool bounded = use_index &&
+        ngram_root_bounds(bounds, rHMgr[i], word, w_word, bigrams, n);
     while (0 != (hp = rHMgr[i]->walk_hashtable(col, hp))) {
-      if ((hp->astr) && (pAMgr) &&
-          (TESTAFF(hp->astr, forbiddenword, hp->alen) ||
-           TESTAFF(hp->astr, ONLYUPCASEFLAG, hp->alen) ||
-           TESTAFF(hp->astr, nosuggest, hp->alen) ||
-           TESTAFF(hp->astr, nongramsuggest, hp->alen) ||
-           TESTAFF(hp->astr, onlyincompound, hp->alen)))
+      // a root replaces the worst one only with a higher score, so skipping
+      // the others keeps the result of scoring all roots
+      if (bounded && bounds[col] <= scores[lp])
         continue;
 
-      if (utf8) {
-        u8_u16(w_f, HENTRY_WORD(hp));
-
-        int leftcommon = leftcommonsubstring(w_word, w_f);
-        if (low) {
-          // lowering dictionary word
-          mkallsmall_utf(w_f, langnum);
-        }
-        sc = ngram(3, w_word, w_f, NGRAM_LONGER_WORSE) + leftcommon;
-      } else {
-        f.assign(HENTRY_WORD(hp));
-
-        int leftcommon = leftcommonsubstring(word, f.c_str());
-        if (low) {
-          // lowering dictionary word
-          mkallsmall(f, csconv);
-        }
-        sc = ngram(3, word, f, NGRAM_LONGER_WORSE) + leftcommon;
-      }
+      if (ngram_excluded_root(hp))
+        continue;
 
-      // check special pronounciation
-      f.clear();
-      if ((hp->var & H_OPT_PHON) &&
-          copy_field(f, HENTRY_DATA(hp), MORPH_PHON)) {
-        int sc2;
-        if (utf8) {
-          u8_u16(w_f, f);
-
-          int leftcommon = leftcommonsubstring(w_word, w_f);
-          if (low) {
-            // lowering dictionary word
-            mkallsmall_utf(w_f, langnum);
-          }
-          sc2 = ngram(3, w_word, w_f, NGRAM_LONGER_WORSE) + leftcommon;
-        } else {
-          int leftcommon = leftcommonsubstring(word, f.c_str());
-          if (low) {
-            // lowering dictionary word
-            mkallsmall(f, csconv);
-          }
-          sc2 = ngram(3, word, f, NGRAM_LONGER_WORSE) + leftcommon;
-        }
-        if (sc2 > sc)
-          sc = sc2;
-      }
+      sc = ngram_root_score(hp, word, w_word, f, w_f);
+      scored++;
 
       int scphon = -20000;
       if (ph && (sc > 2) && (abs(n - (int)hp->clen) <= 3)) {
@@ -1173,6 +1241,9 @@ void SuggestMgr::ngsuggest(std::vector<std::string>& wlst,
             lval = scoresphon[j];
           }
       }
+
+      if ((scored & 1023) == 0 && limits.reached())
+        break;
     }
   }
 
@@ -1233,7 +1304,7 @@ void SuggestMgr::ngsuggest(std::vector<std::string>& wlst,
     return;
   }
 
-  for (int i = 0; i < MAX_ROOTS; i++) {
+  for (int i = 0; i < MAX_ROOTS && !limits.reached(); i++) {
     if (roots[i]) {
       struct hentry* rp = roots[i];
 
@@ -1515,6 +1586,15 @@ void SuggestMgr::ngsuggest(std::vector<std::string>& wlst,
     utf8 = 1;
 }
 
+// limits of a time consuming function started now, its deadline is never
+// later than the deadline of the request
+suggest_limits SuggestMgr::start_timelimit(const suggest_limits& limits) {
+  suggest_limits timelimit(limits);
+  timelimit.deadline =
+      std::min(std::chrono::steady_clock::now() + TIMELIMIT, limits.deadline);
+  return timelimit;
+}
+
 // see if a candidate suggestion is spelled correctly
 // needs to check both root words and words with affixes
 
@@ -1524,12 +1604,12 @@ void SuggestMgr::ngsuggest(std::vector<std::string>& wlst,
 int SuggestMgr::checkword(const std::string& word,
                           int cpdsuggest,
                           int* timer,
-                          clock_t* timelimit) {
+                          const suggest_limits* timelimit) {
   // check time limit
   if (timer) {
     (*timer)--;
     if (!(*timer) && timelimit) {
-      if ((clock() - *timelimit) > TIMELIMIT)
+      if (timelimit->reached())
         return 0;
       *timer = MAXPLUSTIMER;
     }
@@ -1834,6 +1914,131 @@ std::string SuggestMgr::suggest_gen(const std::vector<std::string>& desc, const
   return result2;
 }
 
+// roots never suggested by n-gram similarity
+bool SuggestMgr::ngram_excluded_root(const struct hentry* hp) const {
+  return hp->astr && pAMgr &&
+         (TESTAFF(hp->astr, pAMgr->get_forbiddenword(), hp->alen) ||
+          TESTAFF(hp->astr, ONLYUPCASEFLAG, hp->alen) ||
+          TESTAFF(hp->astr, pAMgr->get_nosuggest(), hp->alen) ||
+          TESTAFF(hp->astr, pAMgr->get_nongramsuggest(), hp->alen) ||
+          TESTAFF(hp->astr, pAMgr->get_onlyincompound(), hp->alen));
+}
+
+// n-gram similarity of a root (or its ph: field) to the word for ngsuggest()
+int SuggestMgr::ngram_root_score(struct hentry* hp,
+                                 const char* word,
+                                 const std::vector<w_char>& w_word,
+                                 std::string& f,
+                                 std::vector<w_char>& w_f) {
+  int low = NGRAM_LOWERING;
+  int sc;
+  if (utf8) {
+    u8_u16(w_f, HENTRY_WORD(hp));
+
+    int leftcommon = leftcommonsubstring(w_word, w_f);
+    if (low) {
+      // lowering dictionary word
+      mkallsmall_utf(w_f, langnum);
+    }
+    sc = ngram(3, w_word, w_f, NGRAM_LONGER_WORSE) + leftcommon;
+  } else {
+    f.assign(HENTRY_WORD(hp));
+
+    int leftcommon = leftcommonsubstring(word, f.c_str());
+    if (low) {
+      // lowering dictionary word
+      mkallsmall(f, csconv);
+    }
+    sc = ngram(3, word, f, NGRAM_LONGER_WORSE) + leftcommon;
+  }
+
+  // check special pronounciation
+  f.clear();
+  if ((hp->var & H_OPT_PHON) &&
+      copy_field(f, HENTRY_DATA(hp), MORPH_PHON)) {
+    int sc2;
+    if (utf8) {
+      u8_u16(w_f, f);
+
+      int leftcommon = leftcommonsubstring(w_word, w_f);
+      if (low) {
+        // lowering dictionary word
+        mkallsmall_utf(w_f, langnum);
+      }
+      sc2 = ngram(3, w_word, w_f, NGRAM_LONGER_WORSE) + leftcommon;
+    } else {
+      int leftcommon = leftcommonsubstring(word, f.c_str());
+      if (low) {
+        // lowering dictionary word
+        mkallsmall(f, csconv);
+      }
+      sc2 = ngram(3, word, f, NGRAM_LONGER_WORSE) + leftcommon;
+    }
+    if (sc2 > sc)
+      sc = sc2;
+  }
+  return sc;
+}
+
+static int bit_count(uint64_t v) {
+  int count = 0;
+  for (; v; v &= v - 1)
+    count++;
+  return count;
+}
+
+// Upper bounds of ngram_root_score() for the roots of a dictionary in
+// walk_hashtable() order, from its bigram index: found characters of the
+// word, found bigrams (positions), trigrams (both of their bigrams found) and
+// leading characters in common (bigrams found from the start, plus one)
+// minus length penalty.
+bool SuggestMgr::ngram_root_bounds(std::vector<int>& bounds,
+                                   HashMgr* pHMgr,
+                                   const char* word,
+                                   const std::vector<w_char>& w_word,
+                                   const std::vector<unsigned int>& bigrams,
+                                   int n) {
+  if (bigrams.empty() || bigrams.size() > 64)
+    return false;
+  std::vector<uint64_t> positions, signatures;
+  pHMgr->match_bigrams(bigrams, positions, signatures);
+
+  // number of word characters by signature bits
+  std::vector<std::pair<uint32_t, int> > chars;
+  for (int i = 0; i < n; i++) {
+    unsigned short c = utf8 ? (w_word[i].h << 8) + w_word[i].l
+                            : (unsigned char)word[i];
+    size_t j = 0;
+    while (j < chars.size() && chars[j].first != SIGNATURE_CHAR_BIT(c))
+      j++;
+    if (j == chars.size())
+      chars.push_back(std::make_pair(SIGNATURE_CHAR_BIT(c), 0));
+    chars[j].second++;
+  }
+
+  int size = pHMgr->get_walk_size();
+  bounds.resize(size);
+  for (int pos = 0; pos < size; pos++) {
+    uint64_t signature = signatures[pos];
+    uint64_t found =
+        positions[pos] & (((uint64_t)2 << (bigrams.size() - 1)) - 1);
+    int bound = 0;
+    for (size_t i = 0; i < chars.size(); i++) {
+      if (SIGNATURE_CHARS(signature) & chars[i].first)
+        bound += chars[i].second;
+    }
+    bound += bit_count(found) + bit_count(found & (found >> 1));
+    for (uint64_t lead = found; lead & 1; lead >>= 1)
+      bound++;
+    bound++;
+    int length = SIGNATURE_LENGTH(signature);
+    if (length && length - n - 2 > 0)
+      bound -= length - n - 2;
+    bounds[pos] = bound;
+  }
+  return true;
+}
+
 // generate an n-gram score comparing s1 and s2, UTF16 version
 int SuggestMgr::ngram(int n,
                       const std::vector<w_char>& su1,
@@ -78,8 +78,8 @@
 #define MAXPHONSUGS 2
 #define MAXCOMPOUNDSUGS 3
 
-// timelimit: max ~1/4 sec (process time on Linux) for a time consuming function
-#define TIMELIMIT (CLOCKS_PER_SEC >> 2)
+// timelimit: max ~1/4 sec (wall-clock time) for a time consuming function
+#define TIMELIMIT std::chrono::milliseconds(250)
 #define MINTIMER 100
 #define MAXPLUSTIMER 100
 
@@ -92,7 +92,6 @@
 #include "affixmgr.hxx"
 #include "hashmgr.hxx"
 #include "langnum.hxx"
-#include <time.h>
 
 enum { LCS_UP, LCS_LEFT, LCS_UPLEFT };
 
@@ -124,8 +123,10 @@ class SuggestMgr {
   SuggestMgr(const char* tryme, unsigned int maxn, AffixMgr* aptr);
   ~SuggestMgr();
 
-  void suggest(std::vector<std::string>& slst, const char* word, int* onlycmpdsug);
-  void ngsuggest(std::vector<std::string>& slst, const char* word, const std::vector<HashMgr*>& rHMgr);
+  void suggest(std::vector<std::string>& slst, const char* word, int* onlycmpdsug,
+               const suggest_limits& limits);
+  void ngsuggest(std::vector<std::string>& slst, const char* word, const std::vector<HashMgr*>& rHMgr,
+                 const suggest_limits& limits);
 
   std::string suggest_morph(const std::string& word);
   std::string suggest_gen(const std::vector<std::string>& pl, const std::string& pattern);
@@ -135,33 +136,39 @@ class SuggestMgr {
                const std::string& candidate,
                int cpdsuggest,
                int* timer,
-               clock_t* timelimit);
-  int checkword(const std::string& word, int, int*, clock_t*);
+               const suggest_limits* timelimit);
+  int checkword(const std::string& word, int, int*, const suggest_limits*);
+  static suggest_limits start_timelimit(const suggest_limits& limits);
   int check_forbidden(const char*, int);
 
   void capchars(std::vector<std::string>&, const char*, int);
   int replchars(std::vector<std::string>&, const char*, int);
   int doubletwochars(std::vector<std::string>&, const char*, int);
-  int forgotchar(std::vector<std::string>&, const char*, int);
+  int forgotchar(std::vector<std::string>&, const char*, int,
+                 const suggest_limits&);
   int swapchar(std::vector<std::string>&, const char*, int);
   int longswapchar(std::vector<std::string>&, const char*, int);
   int movechar(std::vector<std::string>&, const char*, int);
   int extrachar(std::vector<std::string>&, const char*, int);
   int badcharkey(std::vector<std::string>&, const char*, int);
-  int badchar(std::vector<std::string>&, const char*, int);
+  int badchar(std::vector<std::string>&, const char*, int,
+              const suggest_limits&);
   int twowords(std::vector<std::string>&, const char*, int);
 
   void capchars_utf(std::vector<std::string>&, const w_char*, int wl, int);
   int doubletwochars_utf(std::vector<std::string>&, const w_char*, int wl, int);
-  int forgotchar_utf(std::vector<std::string>&, const w_char*, int wl, int);
+  int forgotchar_utf(std::vector<std::string>&, const w_char*, int wl, int,
+                     const suggest_limits&);
   int extrachar_utf(std::vector<std::string>&, const w_char*, int wl, int);
   int badcharkey_utf(std::vector<std::string>&, const w_char*, int wl, int);
-  int badchar_utf(std::vector<std::string>&, const w_char*, int wl, int);
+  int badchar_utf(std::vector<std::string>&, const w_char*, int wl, int,
+                  const suggest_limits&);
   int swapchar_utf(std::vector<std::string>&, const w_char*, int wl, int);
   int longswapchar_utf(std::vector<std::string>&, const w_char*, int, int);
   int movechar_utf(std::vector<std::string>&, const w_char*, int, int);
 
-  int mapchars(std::vector<std::string>&, const char*, int);
+  int mapchars(std::vector<std::string>&, const char*, int,
+               const suggest_limits&);
   int map_related(const char*,
                   std::string&,
                   int,
@@ -169,10 +176,22 @@ class SuggestMgr {
                   int,
                   const std::vector<mapentry>&,
                   int*,
-                  clock_t*);
+                  const suggest_limits*);
   int ngram(int n, const std::vector<w_char>& su1,
             const std::vector<w_char>& su2, int opt);
   int ngram(int n, const std::string& s1, const std::string& s2, int opt);
+  bool ngram_excluded_root(const struct hentry* hp) const;
+  int ngram_root_score(struct hentry* hp,
+                       const char* word,
+                       const std::vector<w_char>& w_word,
+                       std::string& f,
+                       std::vector<w_char>& w_f);
+  bool ngram_root_bounds(std::vector<int>& bounds,
+                         HashMgr* pHMgr,
+                         const char* word,
+                         const std::vector<w_char>& w_word,
+                         const std::vector<unsigned int>& bigrams,
+                         int n);
   int mystrlen(const char* word);
   int leftcommonsubstring(const std::vector<w_char>& su1,
                           const std::vector<w_char>& su2);
@@ -0,0 +1,91 @@
+# Generates src/utils/unicode_tables.cpp, two-stage lookup tables of character properties for BMP
+# Tables must give the same results as user32 IsCharAlphaNumericW, IsCharUpperW and IsCharLowerW. On Windows they are
+# taken from user32 itself, elsewhere they are derived from Unicode data by rules following user32 classification.
+# Run with --verify on Windows to list characters for which these rules differ from user32.
+import sys
+import unicodedata
+
+alnum = 1
+upper = 2
+lower = 4
+
+def unicode_char_flags (code):
+	char = chr (code)
+	category = unicodedata.category (char)
+	flags = 0
+	# Uppercase and Lowercase properties include Other_Uppercase and Other_Lowercase (e.g. circled letters, roman
+	# numerals, ordinal indicators), user32 treats titlecase letters as both
+	if char.isupper () or category == "Lt":
+		flags |= upper
+	if char.islower () or category == "Lt":
+		flags |= lower
+	# Other numbers (e.g. vulgar fractions) are punctuation for user32 unless they have a digit value
+	if category[0] in "LM" or category in ("Nd", "Nl") or unicodedata.digit (char, None) is not None or flags:
+		flags |= alnum
+	return flags
+
+def user32_char_flags_getter ():
+	import ctypes
+	user32 = ctypes.windll.user32
+	def user32_char_flags (code):
+		char = ctypes.c_wchar (chr (code))
+		flags = 0
+		if user32.IsCharAlphaNumericW (char):
+			flags |= alnum
+		if user32.IsCharUpperW (char):
+			flags |= upper
+		if user32.IsCharLowerW (char):
+			flags |= lower
+		return flags
+	return user32_char_flags
+
+def flag_names (flags):
+	return "|".join (name for name, flag in (("alnum", alnum), ("upper", upper), ("lower", lower)) if flags & flag) or "none"
+
+def verify (user32_char_flags):
+	differences = 0
+	for code in range (0x10000):
+		expected = user32_char_flags (code)
+		actual = unicode_char_flags (code)
+		if expected != actual:
+			print ("U+{:04X} {}: user32 {}, rules {}".format (code, unicodedata.category (chr (code)), flag_names (expected), flag_names (actual)))
+			differences += 1
+	print ("{} differences".format (differences))
+	return differences == 0
+
+def main ():
+	char_flags = unicode_char_flags
+	source = "Unicode {}".format (unicodedata.unidata_version)
+	if sys.platform == "win32":
+		char_flags = user32_char_flags_getter ()
+		source = "user32"
+		if "--verify" in sys.argv:
+			sys.exit (0 if verify (char_flags) else 1)
+	elif "--verify" in sys.argv:
+		sys.exit ("Verification against user32 needs Windows")
+
+	blocks = []
+	block_index = []
+	for high in range (256):
+		block = tuple (char_flags (high * 256 + low) for low in range (256))
+		if block not in blocks:
+			blocks.append (block)
+		block_index.append (blocks.index (block))
+
+	with open ("src/utils/unicode_tables.cpp", "w", newline="\n") as f:
+		f.write ("// Generated by generate_unicode_tables.py from {}, do not edit\n".format (source))
+		f.write ("#include \"unicode.h\"\n\n")
+		f.write ("const unsigned char unicode_block_index[256] = {\n")
+		for i in range (0, 256, 16):
+			f.write ("    " + ", ".join (str (x) for x in block_index[i:i + 16]) + ",\n")
+		f.write ("};\n\n")
+		f.write ("const unsigned char unicode_blocks[][256] = {\n")
+		for block in blocks:
+			f.write ("    {\n")
+			for i in range (0, 256, 32):
+				f.write ("        " + ", ".join (str (x) for x in block[i:i + 32]) + ",\n")
+			f.write ("    },\n")
+		f.write ("};\n")
+
+if __name__ == "__main__":
+	main ()
@@ -102,9 +102,10 @@ void AspellInterface::set_multiple_languages(const std::vector<std::wstring>& li
 
         delete_aspell_config(spell_config);
     }
+    m_speller_order.reset(m_spellers.size());
 }
 
-std::vector<std::wstring> AspellInterface::get_suggestions(const wchar_t* word) {
+std::vector<std::wstring> AspellInterface::get_suggestions(const wchar_t* word, size_t max_count) {
     const AspellWordList* word_list = nullptr;
     auto target_word = to_utf8_string(word);
 
@@ -132,12 +133,34 @@ std::vector<std::wstring> AspellInterface::get_suggestions(const wchar_t* word)
     const char* suggestion;
 
     std::vector<std::wstring> sugg_list;
-    while ((suggestion = aspell_string_enumeration_next(els)) != nullptr) {
+    // Only suggestions which will be shown are converted
+    while ((!max_count || sugg_list.size() < max_count) && (suggestion = aspell_string_enumeration_next(els)) != nullptr) {
         sugg_list.push_back(utf8_to_wstring (suggestion));
     }
     return sugg_list;
 }
 
+std::optional<size_t> AspellInterface::get_selected_dictionary() const {
+    if (!m_last_selected_speller)
+        return std::nullopt;
+    if (!m_multi_mode)
+        return 0;
+    auto it = std::find_if(m_spellers.begin(), m_spellers.end(),
+                           [this](const SpellerPtr& speller) { return speller.get() == m_last_selected_speller; });
+    if (it == m_spellers.end())
+        return std::nullopt;
+    return static_cast<size_t>(it - m_spellers.begin());
+}
+
+void AspellInterface::select_dictionary(std::optional<size_t> index) {
+    if (!index)
+        m_last_selected_speller = nullptr;
+    else if (!m_multi_mode)
+        m_last_selected_speller = m_single_speller.get();
+    else
+        m_last_selected_speller = *index < m_spellers.size() ? m_spellers[*index].get() : nullptr;
+}
+
 void AspellInterface::add_to_dictionary(const wchar_t* word) {
     auto target_word = to_utf8_string(word);;
     if (!m_last_selected_speller)
@@ -190,11 +213,11 @@ bool AspellInterface::check_word(const wchar_t* word) {
         if (m_spellers.empty())
             return true;
 
-        for (auto& speller : m_spellers) {
-            res = res || aspell_speller_check(speller.get(), dst_word.c_str(), len);
-            if (res)
-                break;
-        }
+        // All Aspell dictionaries are used through UTF-8 so the word is converted only once
+        res = m_speller_order.find_first([&](size_t index)
+        {
+            return aspell_speller_check(m_spellers[index].get(), dst_word.c_str(), len) != 0;
+        });
     }
     return res;
 }
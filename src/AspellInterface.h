@@ -23,6 +23,7 @@ struct AspellCanHaveError;
 struct AspellSpeller;
 
 #include "SpellerInterface.h"
+#include "SpellerOrder.h"
 
 class LanguageInfo;
 
@@ -38,7 +39,9 @@ public:
   bool
   check_word(const wchar_t* word) override; // Word in Utf-8 or ANSI (For now only Utf-8)
   bool is_working() const override;
-    std::vector<std::wstring> get_suggestions(const wchar_t* word) override;
+    std::vector<std::wstring> get_suggestions(const wchar_t* word, size_t max_count) override;
+  std::optional<size_t> get_selected_dictionary() const override;
+  void select_dictionary(std::optional<size_t> index) override;
   void add_to_dictionary(const wchar_t* word) override;
   void ignore_all(const wchar_t* word) override;
   void set_allow_run_together (bool allow);
@@ -53,6 +56,7 @@ private:
   AspellSpeller *m_last_selected_speller;
   SpellerPtr m_single_speller;
   std::vector<SpellerPtr> m_spellers;
+  SpellerOrder m_speller_order;
   bool m_allow_run_together;
   bool m_aspell_loaded;
   HWND m_npp_window; // For message boxes
@@ -22,45 +22,98 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "Plugin.h"
 #include <cassert>
 #include "utils/utf8.h"
+#include <mutex>
+#include <unordered_map>
+
+// Opening iconv converter is expensive but a single one can't be used by several threads at once,
+// so converters are taken from the pool for the time of conversion and returned there afterwards.
+class IconvPool {
+public:
+    ~IconvPool() {
+        for (auto& [encodings, converters] : m_free_converters)
+            for (auto converter : converters)
+                iconv_close(converter);
+    }
+
+    // Encoding names are always literals from this file so they're identified by pointers
+    iconv_t acquire(const char* source_enc, const char* target_enc) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& converters = m_free_converters[{source_enc, target_enc}];
+            if (!converters.empty()) {
+                auto converter = converters.back();
+                converters.pop_back();
+                return converter;
+            }
+        }
+        return iconv_open(target_enc, source_enc);
+    }
+
+    void release(const char* source_enc, const char* target_enc, iconv_t converter) {
+        // Resets shift state
+        iconv(converter, nullptr, nullptr, nullptr, nullptr);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free_converters[{source_enc, target_enc}].push_back(converter);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::map<std::pair<const char*, const char*>, std::vector<iconv_t>> m_free_converters;
+};
+
+static IconvPool iconv_pool;
 
 static std::vector<char> convert(const char* source_enc, const char* target_enc, const void* source_data_ptr,
                                  size_t source_len, size_t max_dest_len) {
+    iconv_t converter = iconv_pool.acquire(source_enc, target_enc);
+    if (converter == reinterpret_cast<iconv_t>(-1))
+        return {};
     std::vector<char> buf(max_dest_len);
     char* out_buf = reinterpret_cast<char *>(buf.data());
-    iconv_t converter = iconv_open(target_enc, source_enc);
     auto char_ptr = static_cast<const char *>(source_data_ptr);
     size_t res =
         iconv(converter, static_cast<const char **>(&char_ptr), &source_len, &out_buf, &max_dest_len);
-    iconv_close(converter);
+    iconv_pool.release(source_enc, target_enc, converter);
 
     if (res == static_cast<size_t>(-1))
         return {};
     return buf;
 }
 
+// Most of non-UTF-8 documents use single byte ANSI code page, for it conversions are done by direct lookup
+struct AnsiCodepageTable {
+    std::array<wchar_t, 256> to_wide;
+    std::unordered_map<wchar_t, char> from_wide;
+};
+
+static std::optional<AnsiCodepageTable> create_ansi_codepage_table() {
+    CPINFO info;
+    if (!GetCPInfo(CP_ACP, &info) || info.MaxCharSize != 1)
+        return std::nullopt;
+
+    AnsiCodepageTable table;
+    for (int byte = 0; byte < 256; ++byte) {
+        auto c = static_cast<char>(byte);
+        if (MultiByteToWideChar(CP_ACP, 0, &c, 1, &table.to_wide[byte], 1) != 1)
+            return std::nullopt;
+        table.from_wide.emplace(table.to_wide[byte], c);
+    }
+    return table;
+}
+
+static const std::optional<AnsiCodepageTable> ansi_codepage_table = create_ansi_codepage_table();
+
 MappedWstring utf8_to_mapped_wstring(std::string_view str) {
     if (str.empty())
         return {};
-    ptrdiff_t len = str.length();
-    std::vector<wchar_t> buf;
-    std::vector<long> mapping;
-    buf.reserve(len);
-    mapping.reserve(len);
-    auto it = str.data();
     // sadly this garbage skipping is required due to bad find prev mistake algorithm
-    while (utf8_is_cont (*it))
-      ++it;
-    size_t char_cnt = 1;
-    while (it - str.data() < len) {
-        auto next = utf8_inc(it);
-        buf.resize(char_cnt);
-        MultiByteToWideChar(CP_UTF8, 0, it, static_cast<int>(next - it), buf.data() + char_cnt - 1, 1);
-        mapping.push_back(static_cast<long> (it - str.data()));
-        ++char_cnt;
-        it = next;
-    }
-    mapping.push_back(static_cast<long> (it - str.data()));
-    return {std::wstring{buf.begin(), buf.end()}, std::move(mapping)};
+    size_t skipped = 0;
+    while (skipped < str.length() && utf8_is_cont(str[skipped]))
+        ++skipped;
+    MappedWstring result;
+    utf8_decode(str.substr(skipped), result.str, result.mapping);
+    result.mapping.shift(static_cast<long>(skipped));
+    return result;
 }
 
 MappedWstring to_mapped_wstring(std::string_view str) {
@@ -68,6 +121,12 @@ MappedWstring to_mapped_wstring(std::string_view str) {
 }
 
 std::wstring to_wstring(std::string_view source) {
+    if (ansi_codepage_table) {
+        std::wstring result(source.length(), L'\0');
+        std::transform(source.begin(), source.end(), result.begin(),
+                       [](char c) { return ansi_codepage_table->to_wide[static_cast<unsigned char>(c)]; });
+        return result;
+    }
     auto bytes = convert("CHAR", "UCS-2LE//IGNORE", source.data(), source.length(),
                          sizeof(wchar_t) * (source.length() + 1));
     if (bytes.empty()) return {};
@@ -75,6 +134,17 @@ std::wstring to_wstring(std::string_view source) {
 }
 
 std::string to_string(std::wstring_view source) {
+    if (ansi_codepage_table) {
+        std::string result;
+        result.reserve(source.length());
+        // Characters missing from code page are skipped like iconv does with //IGNORE
+        for (auto c : source) {
+            auto it = ansi_codepage_table->from_wide.find(c);
+            if (it != ansi_codepage_table->from_wide.end())
+                result.push_back(it->second);
+        }
+        return result;
+    }
     auto bytes = convert("UCS-2LE", "CHAR//IGNORE", source.data(), (source.length()) * sizeof(wchar_t),
                          sizeof(wchar_t) * (source.length() + 1));
     if (bytes.empty()) return {};
@@ -84,6 +154,8 @@ std::string to_string(std::wstring_view source) {
 constexpr size_t max_utf8_char_length = 6;
 
 std::string to_utf8_string(std::string_view source) {
+    if (ansi_codepage_table)
+        return utf16_to_utf8(to_wstring(source));
     auto bytes = convert("CHAR", "UTF-8//IGNORE", source.data(), source.length(),
                          max_utf8_char_length * (source.length() + 1));
     if (bytes.empty()) return {};
@@ -91,20 +163,16 @@ std::string to_utf8_string(std::string_view source) {
 }
 
 std::string to_utf8_string(std::wstring_view source) {
-    auto bytes = convert("UCS-2LE", "UTF-8//IGNORE", source.data(), source.length() * sizeof (wchar_t),
-                         max_utf8_char_length * (source.length() + 1));
-    if (bytes.empty()) return {};
-    return bytes.data();
+    return utf16_to_utf8(source);
 }
 
 std::wstring utf8_to_wstring(const char* source) {
-    auto bytes = convert("UTF-8", "UCS-2LE//IGNORE", source, strlen(source),
-                         (utf8_length(source) + 1) * sizeof (wchar_t));
-    if (bytes.empty()) return {};
-    return reinterpret_cast<const wchar_t *>(bytes.data());
+    return utf8_to_utf16(source);
 }
 
 std::string utf8_to_string(const char* source) {
+    if (ansi_codepage_table)
+        return to_string(utf8_to_wstring(source));
     auto bytes = convert("UTF-8", "CHAR//IGNORE", source, strlen(source),
                          utf8_length(source) + 1);
     if (bytes.empty()) return {};
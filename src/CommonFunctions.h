@@ -19,18 +19,18 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #pragma once
 #include "Plugin.h"
+#include "utils/OffsetMapping.h"
 
 struct NppData;
 
 class MappedWstring {
 public:
-    long to_original_index(long cur_index) const { return !mapping.empty() ? mapping[cur_index] : cur_index; }
+    long to_original_index(long cur_index) const { return !mapping.empty() ? mapping.to_original(cur_index) : cur_index; }
 
-    long from_original_index(long cur_index) const { return !mapping.empty() ?
-        static_cast<long> (std::lower_bound(mapping.begin (), mapping.end (), cur_index) - mapping.begin ()) : cur_index; }
+    long from_original_index(long cur_index) const { return !mapping.empty() ? mapping.from_original(cur_index) : cur_index; }
 public:
     std::wstring str;
-    std::vector<long> mapping; // should have size str.length () or empty (if empty mapping is identity a<->a)
+    OffsetMapping mapping; // should have size str.length () + 1 or empty (if empty mapping is identity a<->a)
     // indices should correspond to offsets string `str` had in original encoding
 };
 
@@ -35,7 +35,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 extern FuncItem func_item[nb_func]; // NOLINT
 extern NppData npp_data; // NOLINT
 extern bool do_close_tag; // NOLINT
-std::vector<std::pair<long, long>> check_queue;
 UINT_PTR ui_timer = 0u;
 UINT_PTR recheck_timer = 0u;
 bool recheck_done = true;
@@ -101,6 +100,7 @@ LRESULT CALLBACK sub_wnd_proc_notepad(HWND h_wnd, UINT message, WPARAM w_param,
                         insert_sugg_menu_item(menu, item.text.c_str(), item.id, i, item.separator);
                         ++i;
                     }
+                    get_spell_checker()->set_open_suggestions_menu(menu);
                 }
             }
             cur_menu_list.clear();
@@ -200,7 +200,7 @@ void WINAPI do_recheck(HWND, UINT, UINT_PTR, DWORD)
         SetTimer(npp_data.npp_handle, recheck_timer, USER_TIMER_MAXIMUM, do_recheck);
     recheck_done = true;
 
-    get_spell_checker()->recheck_visible(npp_interface().active_view());
+    get_spell_checker()->recheck_modified_both_views();
     if (!first_restyle)
         restyling_caused_recheck_was_done = true;
     first_restyle = false;
@@ -243,7 +243,6 @@ extern "C" __declspec(dllexport) void beNotified(SCNotification* notify_code)
         {
             register_custom_messages();
             init_classes();
-            check_queue.clear();
             load_settings();
             get_spell_checker()->check_file_name();
             create_hooks();
@@ -260,6 +259,7 @@ extern "C" __declspec(dllexport) void beNotified(SCNotification* notify_code)
             if (get_spell_checker())
             {
                 get_spell_checker()->check_file_name();
+                get_spell_checker()->forget_painted_underlines();
                 recheck_visible();
                 restyling_caused_recheck_was_done = false;
             }
@@ -288,8 +288,13 @@ extern "C" __declspec(dllexport) void beNotified(SCNotification* notify_code)
         if (notify_code->modificationType &
             (SC_MOD_DELETETEXT | SC_MOD_INSERTTEXT))
         {
-            if (recheck_timer)
+            // Document shown in both views is reported by each of them
+            auto view = npp_interface().view_from_scintilla_hwnd(static_cast<HWND>(notify_code->nmhdr.hwndFrom));
+            if (recheck_timer && view)
             {
+                get_spell_checker()->on_text_modified(*view, notify_code->position,
+                                                      notify_code->length,
+                                                      (notify_code->modificationType & SC_MOD_INSERTTEXT) != 0);
                 SetTimer(npp_data.npp_handle, recheck_timer, get_settings().recheck_delay, do_recheck);
                 recheck_done = false;
             }
@@ -0,0 +1,97 @@
+#include "DocumentMisspellings.h"
+
+std::vector<std::pair<std::wstring, int>> count_misspelled_words(const std::vector<Misspelling>& misspellings) {
+    std::vector<std::pair<std::wstring, int>> words;
+    std::unordered_map<std::wstring_view, size_t> word_index;
+    for (auto& misspelling : misspellings) {
+        auto [it, inserted] = word_index.emplace(misspelling.word, words.size());
+        if (inserted)
+            words.emplace_back(misspelling.word, 0);
+        ++words[it->second].second;
+    }
+    return words;
+}
+
+DocumentMisspellings::DocumentMisspellings(std::vector<Misspelling> misspellings)
+    : m_misspellings(std::move(misspellings)) {
+}
+
+void DocumentMisspellings::on_text_modified(long position, long length, bool inserted) {
+    auto modified_end = inserted ? position : position + length;
+    // Misspellings adjacent to modification are dropped too since they might have been extended by it
+    auto first = first_ending_not_before(position);
+    auto last = std::upper_bound(first, m_misspellings.cend(), modified_end,
+                                 [](long pos, const Misspelling& misspelling) { return pos < misspelling.start; });
+    auto it = m_misspellings.erase(first, last);
+    auto delta = inserted ? length : -length;
+    for (; it != m_misspellings.end(); ++it) {
+        it->start += delta;
+        it->end += delta;
+    }
+
+    auto shift = [&](long& pos)
+    {
+        if (inserted) {
+            if (pos >= position)
+                pos += length;
+        }
+        else {
+            if (pos >= position + length)
+                pos -= length;
+            else if (pos > position)
+                pos = position;
+        }
+    };
+    for (auto& range : m_dirty_ranges) {
+        shift(range.first);
+        shift(range.second);
+    }
+
+    std::pair<long, long> modified_range{position, inserted ? position + length : position};
+    m_dirty_ranges.insert(std::lower_bound(m_dirty_ranges.begin(), m_dirty_ranges.end(), modified_range),
+                          modified_range);
+    std::vector<std::pair<long, long>> merged;
+    for (auto& range : m_dirty_ranges) {
+        if (!merged.empty() && range.first <= merged.back().second)
+            merged.back().second = std::max(merged.back().second, range.second);
+        else
+            merged.push_back(range);
+    }
+    m_dirty_ranges = std::move(merged);
+}
+
+const std::vector<std::pair<long, long>>& DocumentMisspellings::get_dirty_ranges() const {
+    return m_dirty_ranges;
+}
+
+void DocumentMisspellings::update_range(long from, long to, std::vector<Misspelling> misspellings) {
+    auto starts_before = [](const Misspelling& misspelling, long pos) { return misspelling.start < pos; };
+    auto first = std::lower_bound(m_misspellings.begin(), m_misspellings.end(), from, starts_before);
+    auto last = std::lower_bound(first, m_misspellings.end(), to, starts_before);
+    auto it = m_misspellings.erase(first, last);
+    m_misspellings.insert(it, std::make_move_iterator(misspellings.begin()),
+                          std::make_move_iterator(misspellings.end()));
+
+    std::vector<std::pair<long, long>> remaining;
+    for (auto range : m_dirty_ranges) {
+        if (range.first < from)
+            remaining.emplace_back(range.first, std::min(range.second, from));
+        if (range.second > to)
+            remaining.emplace_back(std::max(range.first, to), range.second);
+    }
+    m_dirty_ranges = std::move(remaining);
+}
+
+const std::vector<Misspelling>& DocumentMisspellings::get() const {
+    return m_misspellings;
+}
+
+DocumentMisspellings::Iterator DocumentMisspellings::first_ending_after(long position) const {
+    return std::upper_bound(m_misspellings.begin(), m_misspellings.end(), position,
+                            [](long pos, const Misspelling& misspelling) { return pos < misspelling.end; });
+}
+
+DocumentMisspellings::Iterator DocumentMisspellings::first_ending_not_before(long position) const {
+    return std::lower_bound(m_misspellings.begin(), m_misspellings.end(), position,
+                            [](const Misspelling& misspelling, long pos) { return misspelling.end < pos; });
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+struct Misspelling {
+    long start;
+    long end;
+    std::wstring word;
+};
+
+// Distinct words in order of their first occurrence along with number of occurrences
+std::vector<std::pair<std::wstring, int>> count_misspelled_words(const std::vector<Misspelling>& misspellings);
+
+// Sorted non-overlapping misspellings found by checking the whole document.
+// Modifications shift positions of misspellings after them and drop the ones they touch,
+// modified parts are kept as dirty ranges until they are checked again.
+class DocumentMisspellings {
+public:
+    using Iterator = std::vector<Misspelling>::const_iterator;
+
+    DocumentMisspellings() = default;
+    explicit DocumentMisspellings(std::vector<Misspelling> misspellings);
+    void on_text_modified(long position, long length, bool inserted);
+    const std::vector<std::pair<long, long>>& get_dirty_ranges() const;
+    // Replaces everything starting in [from, to) by misspellings found there, range is no longer dirty afterwards
+    void update_range(long from, long to, std::vector<Misspelling> misspellings);
+    const std::vector<Misspelling>& get() const;
+    Iterator first_ending_after(long position) const;
+    Iterator first_ending_not_before(long position) const;
+
+private:
+    std::vector<Misspelling> m_misspellings;
+    std::vector<std::pair<long, long>> m_dirty_ranges; // sorted and non-overlapping
+};
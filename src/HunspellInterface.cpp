@@ -27,6 +27,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "Plugin.h"
 #include "LanguageInfo.h"
 
+#include <array>
 #include <io.h>
 #include <fcntl.h>
 
@@ -73,19 +74,33 @@ static std::vector<std::wstring> list_files(const wchar_t* path, const wchar_t*
     return out;
 }
 
+bool DicInfo::to_dictionary_encoding(std::wstring_view input, std::string& output) const {
+    return convert_impl(converter, input, output);
+}
+
+bool DicInfo::from_dictionary_encoding(std::string_view input, std::wstring& output) const {
+    return convert_impl(back_converter, input, output);
+}
+
 std::string DicInfo::to_dictionary_encoding(std::wstring_view input) const {
-    return convert_impl<char>(converter, input);
+    std::string output;
+    to_dictionary_encoding(input, output);
+    return output;
 }
 
 std::wstring DicInfo::from_dictionary_encoding(std::string_view input) const {
-    return convert_impl<wchar_t>(back_converter, input);
+    std::wstring output;
+    from_dictionary_encoding(input, output);
+    return output;
 }
 
-HunspellInterface::HunspellInterface(HWND npp_window_arg): m_use_one_dic(false) {
+HunspellInterface::HunspellInterface(HWND npp_window_arg): m_use_one_dic(false),
+                                                            m_loaded_dictionaries(std::make_shared<LoadedDictionaries>()) {
     m_npp_window = npp_window_arg;
     m_singular_speller = {};
     m_last_selected_speller = {};
     m_is_hunspell_working = false;
+    m_loaded_dictionaries->on_loaded = [this]() { dictionary_loaded(); };
 }
 
 void HunspellInterface::update_on_dic_removal(wchar_t* path,
@@ -176,6 +191,7 @@ static void write_user_dic(const std::unordered_set<std::basic_string<CharType>>
 
 HunspellInterface::~HunspellInterface() {
     m_is_hunspell_working = false;
+    m_loaded_dictionaries->on_loaded = nullptr;
 
     if (!m_system_wrong_dic_path.empty() && !m_user_dic_path.empty() &&
         !are_paths_equal(m_system_wrong_dic_path.c_str(), m_user_dic_path.c_str())) {
@@ -200,40 +216,25 @@ std::vector<LanguageInfo> HunspellInterface::get_language_list() const {
     return list;
 }
 
-DicInfo* HunspellInterface::create_hunspell(const wchar_t* name, int type) {
-    std::wstring aff_buf = (type ? m_sys_dic_dir : m_dic_dir) + L"\\"s + name;
-    {
-        auto it =
-            m_all_hunspells.find(aff_buf);
-        if (it != m_all_hunspells.end()) {
-            return &it->second;
-        }
-    }
-    aff_buf += L".aff";
-    std::wstring dic_buf = (type ? m_sys_dic_dir : m_dic_dir) + L"\\"s + name + L".dic";
-    auto aff_buf_ansi = to_string(aff_buf.c_str());
-    auto dic_buf_ansi = to_string(dic_buf.c_str());
+DicInfo HunspellInterface::load_dictionary(const std::wstring& aff_path, const std::wstring& dic_path,
+                                           std::wstring local_dic_path) {
+    auto aff_buf_ansi = to_string(aff_path.c_str());
+    auto dic_buf_ansi = to_string(dic_path.c_str());
     auto new_hunspell = std::make_unique<Hunspell>(aff_buf_ansi.c_str(), dic_buf_ansi.c_str());
-    auto new_name = aff_buf.substr(0, aff_buf.length() - 4);
     DicInfo new_dic;
     const char* dic_enconding = new_hunspell->get_dic_encoding();
     if (stricmp(dic_enconding, "Microsoft-cp1251") == 0)
         dic_enconding = "cp1251"; // Queer fix for encoding which isn't being guessed
     // correctly by libiconv TODO: Find other possible
     // such failures
+    new_dic.encoding = dic_enconding;
     new_dic.converter = {dic_enconding, "UCS-2LE"};
     new_dic.back_converter = {"UCS-2LE", dic_enconding};
-    new_dic.local_dic_path += m_dic_dir + L"\\"s + name + L".usr";
+    new_dic.ascii_compatible = stricmp(dic_enconding, "UTF-8") == 0 || stricmp(dic_enconding, "ISO8859-1") == 0 ||
+        stricmp(dic_enconding, "ISO-8859-1") == 0;
+    new_dic.local_dic_path = std::move(local_dic_path);
 
     read_user_dic(new_dic.local_dic, new_dic.local_dic_path.c_str());
-    {
-        for (auto word : m_memorized) {
-            auto conv_word = new_dic.to_dictionary_encoding(word);
-            if (!conv_word.empty())
-                new_hunspell->add(conv_word.c_str()); // Adding all already memorized words to
-            // newly loaded Hunspell instance
-        }
-    }
     {
         for (auto word : new_dic.local_dic) {
             new_hunspell->add(word.c_str()); // Adding all already memorized words from local
@@ -242,9 +243,79 @@ DicInfo* HunspellInterface::create_hunspell(const wchar_t* name, int type) {
         }
     }
     new_dic.hunspell = std::move(new_hunspell);
-    auto& target = m_all_hunspells[new_name];
-    target = std::move(new_dic);
-    return &target;
+    return new_dic;
+}
+
+DicInfo* HunspellInterface::create_hunspell(const wchar_t* name, int type) {
+    std::wstring aff_buf = (type ? m_sys_dic_dir : m_dic_dir) + L"\\"s + name;
+    {
+        auto it =
+            m_all_hunspells.find(aff_buf);
+        if (it != m_all_hunspells.end()) {
+            return &it->second;
+        }
+    }
+    auto new_name = aff_buf;
+    aff_buf += L".aff";
+    std::wstring dic_buf = (type ? m_sys_dic_dir : m_dic_dir) + L"\\"s + name + L".dic";
+    // Large dictionaries take seconds to load so it's done in parallel on worker threads while
+    // placeholder without Hunspell instance accepts all words
+    concurrency::create_task(
+        [aff_buf, dic_buf, local_dic_path = m_dic_dir + L"\\"s + name + L".usr", new_name,
+            loaded = m_loaded_dictionaries, alive_status = weaken(m_alive_status), hwnd = m_npp_window]()
+        {
+            auto new_dic = load_dictionary(aff_buf, dic_buf, local_dic_path);
+            {
+                std::lock_guard<std::mutex> lock(loaded->mutex);
+                loaded->dictionaries.emplace_back(new_name, std::move(new_dic));
+            }
+            if (alive_status.expired())
+                return;
+
+            auto cb_data = std::make_unique<CallbackData>();
+            // Interface is reached only through shared state, it disconnects itself on destruction
+            cb_data->callback = [loaded]()
+            {
+                if (loaded->on_loaded)
+                    loaded->on_loaded();
+            };
+            cb_data->alive_status = alive_status;
+            PostMessage(hwnd, get_custom_gui_message_id(CustomGuiMessage::generic_callback),
+                        reinterpret_cast<WPARAM>(cb_data.release()), 0);
+        });
+    ++m_loading_count;
+    return &m_all_hunspells[new_name];
+}
+
+void HunspellInterface::take_loaded_dictionaries() {
+    if (m_loading_count == 0)
+        return;
+
+    std::vector<std::pair<std::wstring, DicInfo>> dictionaries;
+    {
+        std::lock_guard<std::mutex> lock(m_loaded_dictionaries->mutex);
+        dictionaries.swap(m_loaded_dictionaries->dictionaries);
+    }
+    if (dictionaries.empty())
+        return;
+
+    for (auto& [name, new_dic] : dictionaries) {
+        // Every started load is counted until its result is taken, even if the result isn't used
+        --m_loading_count;
+        auto it = m_all_hunspells.find(name);
+        // Dictionary could be removed while it was loading or be loaded again after removal
+        if (it == m_all_hunspells.end() || it->second.hunspell)
+            continue;
+
+        for (auto word : m_memorized) {
+            auto conv_word = new_dic.to_dictionary_encoding(word);
+            if (!conv_word.empty())
+                new_dic.hunspell->add(conv_word.c_str()); // Adding all already memorized words to
+            // newly loaded Hunspell instance
+        }
+        it->second = std::move(new_dic);
+    }
+    update_encoding_groups();
 }
 
 void HunspellInterface::set_language(const wchar_t* lang) {
@@ -264,6 +335,8 @@ void HunspellInterface::set_language(const wchar_t* lang) {
 
 void HunspellInterface::set_multiple_languages(const std::vector<std::wstring>& list) {
     m_spellers.clear();
+    m_speller_order.reset(0);
+    m_speller_encoding_group.clear();
 
     if (m_dic_list.empty())
         return;
@@ -279,49 +352,89 @@ void HunspellInterface::set_multiple_languages(const std::vector<std::wstring>&
             create_hunspell(it->name.c_str(), it->type);
         m_spellers.push_back(ptr);
     }
+
+    m_speller_order.reset(m_spellers.size());
+    update_encoding_groups();
+}
+
+void HunspellInterface::update_encoding_groups() {
+    m_speller_encoding_group.clear();
+    // Encoding of dictionaries which are still loading is unknown, they form a group without use
+    std::vector<std::string_view> group_encodings;
+    for (size_t i = 0; i < m_spellers.size(); ++i) {
+        auto it = std::find(group_encodings.begin(), group_encodings.end(), m_spellers[i]->encoding);
+        m_speller_encoding_group.push_back(it - group_encodings.begin());
+        if (it == group_encodings.end())
+            group_encodings.push_back(m_spellers[i]->encoding);
+    }
 }
 
 template <typename OutputCharType, typename InputCharType>
-std::basic_string<OutputCharType> DicInfo::convert_impl(const IconvWrapperT& conv,
-                                                        std::basic_string_view<InputCharType> input) const {
-    static std::vector<char> buf;
+bool DicInfo::convert_impl(const IconvWrapperT& conv, std::basic_string_view<InputCharType> input,
+                           std::basic_string<OutputCharType>& output) const {
+    using UnsignedInputCharType = std::make_unsigned_t<InputCharType>;
+    if (ascii_compatible && std::all_of(input.begin(), input.end(), [](InputCharType c)
+    {
+        return static_cast<UnsignedInputCharType>(c) < 0x80;
+    })) {
+        output.resize(input.length());
+        std::transform(input.begin(), input.end(), output.begin(),
+                       [](InputCharType c) { return static_cast<OutputCharType>(c); });
+        return true;
+    }
+
+    output.clear();
+    if (conv.get() == iconv_t(-1))
+        return false;
+    // Single UCS-2 character takes at most 6 bytes in any encoding, single byte gives at most one UCS-2 character
     if constexpr (std::is_same_v<OutputCharType, char>)
-      buf.resize((input.length() + 1) * 6);
+      output.resize(input.length() * 6);
     else
-      buf.resize((input.length() + 1) * sizeof (OutputCharType));
-    if (conv.get() == iconv_t(-1)) {
-        buf.front() = '\0';
-        return {};
+      output.resize(input.length());
+    size_t in_size = input.length() * sizeof (InputCharType);
+    size_t out_size = output.length() * sizeof (OutputCharType);
+    auto out_buf = reinterpret_cast<char *>(output.data());
+    auto in_buf = reinterpret_cast<const char *>(input.data());
+    size_t res;
+    {
+        std::lock_guard<std::mutex> lock(*converter_mutex);
+        res = iconv(conv.get(), &in_buf, &in_size, &out_buf, &out_size);
+        // Flushes and resets conversion state
+        if (res != static_cast<size_t>(-1))
+            res = iconv(conv.get(), nullptr, nullptr, &out_buf, &out_size);
+        else
+            iconv(conv.get(), nullptr, nullptr, nullptr, nullptr);
     }
-    size_t in_size = (input.length() + 1) * sizeof (InputCharType);
-    size_t out_size = buf.size ();
-    char* out_buf = buf.data();
-    auto in_buf = input.data();
-    size_t res = iconv(conv.get(), reinterpret_cast<const char **>(&in_buf), &in_size, &out_buf, &out_size);
-    if (res == (size_t)(-1)) {
-        buf.front() = '\0';
+    if (res == static_cast<size_t>(-1)) {
+        output.clear();
+        return false;
     }
-    return {reinterpret_cast<OutputCharType *>(buf.data())};
+    output.resize(output.length() - out_size / sizeof (OutputCharType));
+    return true;
 }
 
-bool HunspellInterface::speller_check_word(const DicInfo& dic, const wchar_t* word) {
-    auto word_to_check = dic.to_dictionary_encoding(word);
-    if (word_to_check.empty())
+bool HunspellInterface::speller_check_word(const DicInfo& dic, const wchar_t* word, std::string& buffer) {
+    if (!dic.hunspell)
+        return true;
+    if (!dic.to_dictionary_encoding(word, buffer) || buffer.empty())
         return true;
     // No additional check for memorized is needed since all words are already in
     // dictionary
 
-    return dic.hunspell->spell(word_to_check);
+    return dic.hunspell->spell(buffer);
 }
 
 bool HunspellInterface::check_word(const wchar_t* word) {
     if (m_ignored.find(word) != m_ignored.end())
         return true;
 
+    take_loaded_dictionaries();
     bool res = false;
     if (!m_multi_mode) {
+        // Conversions of short words don't allocate at all
+        std::string buffer;
         if (m_singular_speller)
-            res = speller_check_word(*m_singular_speller, word);
+            res = speller_check_word(*m_singular_speller, word, buffer);
         else
             res = true;
     }
@@ -329,11 +442,38 @@ bool HunspellInterface::check_word(const wchar_t* word) {
         if (m_spellers.empty())
             return true;
 
-        for (auto& speller : m_spellers) {
-            res = res || speller_check_word(*speller, word);
-            if (res)
-                break;
-        }
+        enum class ConversionState {
+            pending,
+            converted,
+            failed,
+        };
+        struct Conversion {
+            ConversionState state = ConversionState::pending;
+            std::string word;
+        };
+        // Word converted to each encoding is shared by dictionaries using it. Conversions are kept on stack so several
+        // threads can check words at the same time, dictionaries of further encodings convert the word on their own
+        std::array<Conversion, 8> group_conversions;
+        Conversion own_conversion;
+        bool loading = false;
+        res = m_speller_order.find_first([&](size_t index)
+        {
+            auto& speller = *m_spellers[index];
+            if (!speller.hunspell) {
+                loading = true;
+                return false;
+            }
+            auto group = m_speller_encoding_group[index];
+            auto& conversion = group < group_conversions.size() ? group_conversions[group] : own_conversion;
+            if (conversion.state == ConversionState::pending || &conversion == &own_conversion)
+                conversion.state = speller.to_dictionary_encoding(word, conversion.word) && !conversion.word.empty()
+                                       ? ConversionState::converted
+                                       : ConversionState::failed;
+            // Words which can't be represented in dictionary encoding are not checked, same as in speller_check_word
+            return conversion.state == ConversionState::failed || speller.hunspell->spell(conversion.word);
+        });
+        // Word might be found in dictionary which isn't loaded yet
+        res = res || loading;
     }
     return res;
 }
@@ -427,6 +567,9 @@ void HunspellInterface::add_to_dictionary(const wchar_t* word) {
     if (m_use_one_dic) {
         m_memorized.insert(word);
         for (auto& p : m_all_hunspells) {
+            // Memorized words are added to dictionaries which are still loading once they're loaded
+            if (!p.second.hunspell)
+                continue;
             auto conv_word = p.second.to_dictionary_encoding(word);
             if (!conv_word.empty())
                 p.second.hunspell->add(conv_word.c_str());
@@ -446,6 +589,26 @@ void HunspellInterface::add_to_dictionary(const wchar_t* word) {
     }
 }
 
+std::optional<size_t> HunspellInterface::get_selected_dictionary() const {
+    if (!m_last_selected_speller)
+        return std::nullopt;
+    if (!m_multi_mode)
+        return 0;
+    auto it = std::find(m_spellers.begin(), m_spellers.end(), m_last_selected_speller);
+    if (it == m_spellers.end())
+        return std::nullopt;
+    return static_cast<size_t>(it - m_spellers.begin());
+}
+
+void HunspellInterface::select_dictionary(std::optional<size_t> index) {
+    if (!index)
+        m_last_selected_speller = nullptr;
+    else if (!m_multi_mode)
+        m_last_selected_speller = m_singular_speller;
+    else
+        m_last_selected_speller = *index < m_spellers.size() ? m_spellers[*index] : nullptr;
+}
+
 void HunspellInterface::ignore_all(const wchar_t* word) {
     if (!m_last_selected_speller)
         return;
@@ -453,29 +616,95 @@ void HunspellInterface::ignore_all(const wchar_t* word) {
     m_ignored.insert(word);
 }
 
-std::vector<std::wstring> HunspellInterface::get_suggestions(const wchar_t* word) {
+static std::vector<std::wstring> suggestions_from_dictionary_encoding(const DicInfo* dic,
+                                                                      const std::vector<std::string>& list,
+                                                                      size_t max_count) {
+    // Only suggestions which will be shown are converted
+    std::vector<std::wstring> sugg_list(max_count ? std::min(list.size(), max_count) : list.size());
+    std::transform(list.begin(), list.begin() + sugg_list.size(), sugg_list.begin(), [dic](const std::string& s)
+    {
+        return dic->from_dictionary_encoding(s);
+    });
+    return sugg_list;
+}
+
+std::vector<std::wstring> HunspellInterface::get_suggestions(const wchar_t* word, size_t max_count) {
+    return get_suggestions(word, max_count, std::chrono::steady_clock::time_point::max(),
+                           concurrency::cancellation_token::none(), nullptr);
+}
+
+std::vector<std::wstring> HunspellInterface::get_suggestions(
+    const wchar_t* word, size_t max_count, std::chrono::steady_clock::time_point deadline,
+    const concurrency::cancellation_token& ctoken,
+    const std::function<void(const std::vector<std::wstring>&)>& fast_tier) {
+    take_loaded_dictionaries();
     std::vector<std::string> list;
-    m_last_selected_speller = m_singular_speller;
+    DicInfo *selected = nullptr;
 
+    std::vector<DicInfo *> spellers;
     if (!m_multi_mode) {
-        list = m_singular_speller->hunspell->suggest(m_singular_speller->to_dictionary_encoding(word));
+        if (!m_singular_speller || !m_singular_speller->hunspell) {
+            m_last_selected_speller = nullptr;
+            return {};
+        }
+        spellers.push_back(m_singular_speller);
     }
     else {
         for (auto speller : m_spellers) {
-            auto cur_list = speller->hunspell->suggest(speller->to_dictionary_encoding(word));
-            if (cur_list.size() > list.size()) {
-                list = std::move(cur_list);
+            if (speller->hunspell)
+                spellers.push_back(speller);
+        }
+    }
+
+    // Hunspell polls a flag, token sets it
+    std::atomic<bool> cancelled{false};
+    suggest_limits limits;
+    limits.deadline = deadline;
+    limits.cancelled = &cancelled;
+    // Hunspell cuts its complete list to that many
+    limits.max_count = static_cast<unsigned int>(std::min<size_t>(max_count, UINT_MAX));
+    std::optional<concurrency::cancellation_token_registration> registration;
+    if (ctoken.is_cancelable())
+        registration = ctoken.register_callback([&cancelled] { cancelled = true; });
+
+    // Sent once, before the first slower search, with the best list known at that moment
+    bool fast_tier_sent = false;
+    for (auto speller : spellers) {
+        auto on_fast_tier = [&](const std::vector<std::string>& tier)
+        {
+            if (!fast_tier || fast_tier_sent)
+                return;
+            fast_tier_sent = true;
+            // Dictionary of the sent list is selected until the search ends
+            if (!selected || tier.size() > list.size()) {
                 m_last_selected_speller = speller;
+                fast_tier(suggestions_from_dictionary_encoding(speller, tier, max_count));
+            }
+            else {
+                m_last_selected_speller = selected;
+                fast_tier(suggestions_from_dictionary_encoding(selected, list, max_count));
             }
+        };
+        auto cur_list = speller->hunspell->suggest(speller->to_dictionary_encoding(word), limits, on_fast_tier);
+        if (!m_multi_mode || cur_list.size() > list.size()) {
+            list = std::move(cur_list);
+            selected = speller;
         }
+        // Lists are cut to max_count, so remaining dictionaries couldn't give a longer one
+        if (max_count && list.size() >= max_count)
+            break;
     }
 
-    std::vector<std::wstring> sugg_list(list.size());
-    std::transform(list.begin(), list.end(), sugg_list.begin(), [this](const std::string& s)
-    {
-        return m_last_selected_speller->from_dictionary_encoding(s);
-    });
-    return sugg_list;
+    if (registration)
+        ctoken.deregister_callback(*registration);
+    // Search cut short by deadline or cancellation still selects the dictionary it has started with, so the word can
+    // be added to it even if no suggestions were found in time
+    if (!selected && !spellers.empty() && limits.reached())
+        selected = spellers.front();
+    m_last_selected_speller = selected;
+    if (!selected)
+        return {};
+    return suggestions_from_dictionary_encoding(selected, list, max_count);
 }
 
 void HunspellInterface::set_directory(const wchar_t* dir) {
@@ -551,3 +780,13 @@ bool HunspellInterface::get_lang_only_system(const wchar_t* lang) const {
 }
 
 bool HunspellInterface::is_working() const { return m_is_hunspell_working; }
+
+bool HunspellInterface::is_loading() const {
+    if (m_loading_count == 0)
+        return false;
+
+    if (!m_multi_mode)
+        return m_singular_speller && !m_singular_speller->hunspell;
+
+    return std::any_of(m_spellers.begin(), m_spellers.end(), [](const DicInfo* speller) { return !speller->hunspell; });
+}
@@ -19,10 +19,14 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #pragma once
 
 #include "SpellerInterface.h"
+#include "SpellerOrder.h"
 
 #include "iconv.h"
 #include "CommonFunctions.h"
 #include "MainDef.h"
+#include "lsignal.h"
+
+#include <mutex>
 
 class LanguageInfo;
 
@@ -54,16 +58,25 @@ private:
 };
 
 struct DicInfo {
-  std::unique_ptr<Hunspell> hunspell;
+  std::unique_ptr<Hunspell> hunspell; // Null while dictionary is being loaded
   IconvWrapperT converter;
   IconvWrapperT back_converter;
   std::wstring local_dic_path;
+  std::string encoding;
   std::unordered_set<std::string> local_dic; // Stored in Dictionary encoding
+  // Converters are shared by all threads using the dictionary so calls to them are serialized
+  std::shared_ptr<std::mutex> converter_mutex = std::make_shared<std::mutex>();
+  // ASCII words are the same in dictionary encoding so they don't need conversion
+  bool ascii_compatible = false;
+  // Versions writing into caller supplied buffers, return false if conversion failed
+  bool to_dictionary_encoding (std::wstring_view input, std::string& output) const;
+  bool from_dictionary_encoding (std::string_view input, std::wstring& output) const;
   std::string to_dictionary_encoding (std::wstring_view input) const;
   std::wstring from_dictionary_encoding (std::string_view input) const;
 private:
   template <typename CharType, typename InputCharType>
-  std::basic_string<CharType> convert_impl (const IconvWrapperT& conv, std::basic_string_view<InputCharType> input) const;
+  bool convert_impl (const IconvWrapperT& conv, std::basic_string_view<InputCharType> input,
+                     std::basic_string<CharType>& output) const;
 };
 
 
@@ -87,7 +100,14 @@ public:
       const std::vector<std::wstring>& list) override;             // Languages are from LangList
   bool check_word(const wchar_t* word) override; // Word in Utf-8 or ANSI
   bool is_working() const override;
-    std::vector<std::wstring> get_suggestions(const wchar_t* word) override;
+  bool is_loading() const override;
+    std::vector<std::wstring> get_suggestions(const wchar_t* word, size_t max_count) override;
+  std::vector<std::wstring> get_suggestions(const wchar_t* word, size_t max_count,
+                                            std::chrono::steady_clock::time_point deadline,
+                                            const concurrency::cancellation_token& ctoken,
+                                            const std::function<void(const std::vector<std::wstring>&)>& fast_tier) override;
+  std::optional<size_t> get_selected_dictionary() const override;
+  void select_dictionary(std::optional<size_t> index) override;
   void add_to_dictionary(const wchar_t* word) override;
   void ignore_all(const wchar_t* word) override;
 
@@ -98,11 +118,18 @@ public:
                           bool &need_multi_lang_reset);
   bool get_lang_only_system(const wchar_t* lang) const;
 
+  // Emitted in GUI thread when one of requested dictionaries finished loading
+  lsignal::signal<void()> dictionary_loaded;
+
 private:
   template <typename CharType>
   static void read_user_dic(std::unordered_set<std::basic_string<CharType>>& target, const wchar_t* path);
   DicInfo* create_hunspell(const wchar_t* name, int type);
-  static bool speller_check_word(const DicInfo& dic, const wchar_t* word);
+  static DicInfo load_dictionary(const std::wstring& aff_path, const std::wstring& dic_path,
+                                 std::wstring local_dic_path);
+  void take_loaded_dictionaries();
+  void update_encoding_groups();
+  static bool speller_check_word(const DicInfo& dic, const wchar_t* word, std::string& buffer);
   void message_box_word_cannot_be_added();
 
 private:
@@ -112,9 +139,23 @@ private:
   std::wstring m_sys_dic_dir;
   std::set<AvailableLangInfo> m_dic_list;
   std::map<std::wstring, DicInfo> m_all_hunspells;
+  // Dictionaries are loaded on worker threads and put here, they are moved to m_all_hunspells
+  // by the next call which is serialized with checking
+  struct LoadedDictionaries {
+    std::mutex mutex;
+    std::vector<std::pair<std::wstring, DicInfo>> dictionaries;
+    // Called in GUI thread after each loaded dictionary, reset when interface is destroyed
+    std::function<void()> on_loaded;
+  };
+  std::shared_ptr<LoadedDictionaries> m_loaded_dictionaries;
+  size_t m_loading_count = 0;
+  std::shared_ptr<void> m_alive_status = std::make_shared<int>();
   DicInfo *m_singular_speller;
   DicInfo *m_last_selected_speller;
   std::vector<DicInfo *> m_spellers;
+  SpellerOrder m_speller_order;
+  // Dictionaries with the same encoding share index of converted word
+  std::vector<size_t> m_speller_encoding_group;
   std::unordered_set<std::wstring> m_memorized;
   std::unordered_set<std::wstring> m_ignored;
   std::wstring m_user_dic_path;        // For now only default one.
@@ -0,0 +1,126 @@
+#include "PaintedUnderlines.h"
+
+using Ranges = std::vector<std::pair<long, long>>;
+
+static bool contains(const Ranges& ranges, long position) {
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), position,
+                               [](long pos, const std::pair<long, long>& range) { return pos < range.first; });
+    return it != ranges.begin() && std::prev(it)->second > position;
+}
+
+static Ranges::const_iterator first_ending_after(const Ranges& ranges, long position) {
+    return std::upper_bound(ranges.begin(), ranges.end(), position,
+                            [](long pos, const std::pair<long, long>& range) { return pos < range.second; });
+}
+
+static Ranges merged(Ranges ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    Ranges result;
+    for (auto& range : ranges) {
+        if (range.first >= range.second)
+            continue;
+        if (!result.empty() && range.first <= result.back().second)
+            result.back().second = std::max(result.back().second, range.second);
+        else
+            result.push_back(range);
+    }
+    return result;
+}
+
+// Replaces everything inside [from, to) with `inner`
+static void replace_inside(Ranges& ranges, long from, long to, const Ranges& inner) {
+    Ranges result;
+    for (auto range : ranges) {
+        if (range.second <= from || range.first >= to)
+            result.push_back(range);
+        else {
+            if (range.first < from)
+                result.emplace_back(range.first, from);
+            if (range.second > to)
+                result.emplace_back(to, range.second);
+        }
+    }
+    for (auto range : inner)
+        result.emplace_back(std::max(range.first, from), std::min(range.second, to));
+    ranges = merged(std::move(result));
+}
+
+PaintedUnderlines::PaintedUnderlines() {
+    forget();
+}
+
+std::vector<IndicatorRange> PaintedUnderlines::update(long from, long to, const Ranges& underlines) {
+    // Boundaries of all known ranges split [from, to) into segments which are either completely correct or not
+    std::vector<long> bounds{from, to};
+    auto add_bounds = [&](const Ranges& ranges)
+    {
+        for (auto it = first_ending_after(ranges, from); it != ranges.end() && it->first < to; ++it) {
+            bounds.push_back(std::max(it->first, from));
+            bounds.push_back(std::min(it->second, to));
+        }
+    };
+    add_bounds(m_painted);
+    add_bounds(m_unknown);
+    add_bounds(underlines);
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+    std::vector<IndicatorRange> changes;
+    for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+        auto segment_start = bounds[i];
+        auto segment_end = bounds[i + 1];
+        auto wanted = contains(underlines, segment_start);
+        if (!contains(m_unknown, segment_start) && contains(m_painted, segment_start) == wanted)
+            continue;
+
+        if (!changes.empty() && changes.back().to == segment_start && changes.back().fill == wanted)
+            changes.back().to = segment_end;
+        else
+            changes.push_back({segment_start, segment_end, wanted});
+    }
+
+    replace_inside(m_painted, from, to, underlines);
+    replace_inside(m_unknown, from, to, {});
+    return changes;
+}
+
+void PaintedUnderlines::on_text_modified(long position, long length, bool inserted) {
+    auto shift = [&](long& pos)
+    {
+        if (inserted) {
+            if (pos >= position)
+                pos += length;
+        }
+        else {
+            if (pos >= position + length)
+                pos -= length;
+            else if (pos > position)
+                pos = position;
+        }
+    };
+    for (auto& range : m_unknown) {
+        shift(range.first);
+        shift(range.second);
+    }
+    auto modified_end = inserted ? position : position + length;
+    Ranges painted;
+    for (auto range : m_painted) {
+        // Editor extends or cuts indicators touching modification in its own way, so they become unknown
+        bool touched = range.second >= position && range.first <= modified_end;
+        shift(range.first);
+        shift(range.second);
+        (touched ? m_unknown : painted).push_back(range);
+    }
+    m_painted = std::move(painted);
+    m_unknown = merged(std::move(m_unknown));
+}
+
+void PaintedUnderlines::forget() {
+    m_painted.clear();
+    m_unknown = {{0, std::numeric_limits<long>::max()}};
+}
+
+void PaintedUnderlines::set_all_cleared() {
+    m_painted.clear();
+    m_unknown.clear();
+}
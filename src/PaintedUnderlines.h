@@ -0,0 +1,20 @@
+#pragma once
+
+#include "npp/EditorInterface.h"
+
+// Underlines painted in a single view, used to send only differences to editor on recheck.
+// Ranges are half-open [start, end).
+class PaintedUnderlines {
+public:
+    PaintedUnderlines();
+    // Returns changes required to make [from, to) underlined exactly at `underlines` (sorted and non-overlapping)
+    std::vector<IndicatorRange> update(long from, long to, const std::vector<std::pair<long, long>>& underlines);
+    void on_text_modified(long position, long length, bool inserted);
+    // Editor state is no longer known (e.g. other document is shown), everything should be repainted
+    void forget();
+    void set_all_cleared();
+
+private:
+    std::vector<std::pair<long, long>> m_painted;
+    std::vector<std::pair<long, long>> m_unknown; // parts where editor might differ from m_painted
+};
@@ -216,6 +216,8 @@ void find_next_mistake() { get_spell_checker()->find_next_mistake(); }
 
 void find_prev_mistake() { get_spell_checker()->find_prev_mistake(); }
 
+void export_misspellings() { get_spell_checker()->export_misspellings_to_file(); }
+
 void quick_lang_change_context() {
     POINT pos;
     GetCursorPos(&pos);
@@ -294,6 +296,7 @@ void command_menu_init() {
         set_next_command(TEXT("Change Current Language"), quick_lang_change_context, std::move(sh_key),
                          false);
     }
+    set_next_command(TEXT("Export Misspellings to File..."), export_misspellings, nullptr, false);
     set_next_command(TEXT("---"), nullptr, nullptr, false);
 
     set_next_command(TEXT("Settings..."), start_settings, nullptr, false);
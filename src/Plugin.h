@@ -28,7 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 struct SuggestionsMenuItem;
 const wchar_t npp_plugin_name[] = TEXT("DSpellCheck");
 
-const int nb_func = 8;
+const int nb_func = 9;
 #define QUICK_LANG_CHANGE_ITEM 3
 
 enum class CustomGuiMessage;
@@ -73,6 +73,7 @@ void RemoveDictionariesDialog::remove_selected(SpellChecker* spell_checker_insta
     bool need_single_reset = false;
     bool need_multi_reset = false;
     bool single_temp, multi_temp;
+    spell_checker_instance->stop_document_check();
     for (int i = 0; i < ListBox_GetCount(m_lang_list); i++)
     {
         if (CheckedListBox_GetCheckState(m_lang_list, i) == BST_CHECKED)
@@ -106,6 +107,8 @@ void RemoveDictionariesDialog::remove_selected(SpellChecker* spell_checker_insta
                     file_name[wcslen(file_name) - 4] = L'\0';
                     spell_checker_instance->get_hunspell_speller()->update_on_dic_removal(
                         file_name, single_temp, multi_temp);
+                    // Compiled snapshot can be removed only now, it was mapped while dictionary was loaded
+                    DeleteFile((std::wstring(file_name) + L".dic.snapshot").c_str());
                     need_single_reset |= single_temp;
                     need_multi_reset |= multi_temp;
                     count++;
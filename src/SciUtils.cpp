@@ -963,3 +963,17 @@ bool SciUtils::is_comment_or_string(LRESULT lexer, LRESULT style) {
     };
     return false;
 }
+
+const SciUtils::StyleMask& SciUtils::comment_or_string_styles(LRESULT lexer) {
+    static const auto masks = [] {
+        std::array<StyleMask, SCLEX_USER + 1> result;
+        for (int lexer_id = 0; lexer_id < static_cast<int>(result.size()); ++lexer_id)
+            for (int style = 0; style < static_cast<int>(result[lexer_id].size()); ++style)
+                result[lexer_id][style] = is_comment_or_string(lexer_id, style);
+        return result;
+    }();
+    static const StyleMask no_styles;
+    if (lexer < 0 || lexer >= static_cast<LRESULT>(masks.size()))
+        return no_styles;
+    return masks[lexer];
+}
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <bitset>
+
 namespace SciUtils
 {
+    // bit per Scintilla style (STYLE_MAX = 255)
+    using StyleMask = std::bitset<256>;
+
     bool is_comment_or_string(LRESULT lexer, LRESULT style);
+    // all styles for which is_comment_or_string is true, computed once for every known lexer
+    const StyleMask& comment_or_string_styles(LRESULT lexer);
 }
@@ -75,6 +75,7 @@ public:
     bool check_those = false;
     std::wstring file_types;
     bool check_only_comments_and_strings = false;
+    bool check_whole_document_in_background = false;
     int underline_color = 0;
     int underline_style = 0;
     bool ignore_containing_digit = false;
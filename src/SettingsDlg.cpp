@@ -166,6 +166,7 @@ void SimpleDlg::apply_settings(Settings& settings)
     settings.use_language_name_aliases = Button_GetCheck(m_h_decode_names) == BST_CHECKED;
     settings.use_unified_dictionary = Button_GetCheck(m_h_one_user_dic) == BST_CHECKED;
     settings.aspell_allow_run_together_words = Button_GetCheck (m_h_aspell_run_together_cb) == BST_CHECKED;
+    settings.check_whole_document_in_background = Button_GetCheck(m_h_background_check_cb) == BST_CHECKED;
 }
 
 void SimpleDlg::fill_lib_info(int status, const Settings& settings)
@@ -324,6 +325,7 @@ INT_PTR SimpleDlg::run_dlg_proc(UINT message, WPARAM w_param, LPARAM l_param)
             m_h_reset_speller_path = ::GetDlgItem(_hSelf, IDC_RESETSPELLERPATH);
             m_h_system_path = ::GetDlgItem(_hSelf, IDC_SYSTEMPATH);
             m_h_aspell_run_together_cb = ::GetDlgItem(_hSelf, IDC_ASPELL_RUNTOGETHER_CB);
+            m_h_background_check_cb = ::GetDlgItem(_hSelf, IDC_BACKGROUND_CHECK_CB);
             ComboBox_AddString(m_h_hunspell_path_type, L"For Current User");
             ComboBox_AddString(m_h_hunspell_path_type, L"For All Users");
             ComboBox_SetCurSel(m_h_hunspell_path_type, 0);
@@ -937,6 +939,7 @@ void SimpleDlg::update_controls(const Settings& settings)
     set_sugg_type(settings.suggestions_mode);
     set_one_user_dic(settings.use_unified_dictionary);
     Button_SetCheck (m_h_aspell_run_together_cb, settings.aspell_allow_run_together_words);
+    Button_SetCheck(m_h_background_check_cb, settings.check_whole_document_in_background);
 }
 
 INT_PTR SettingsDlg::run_dlg_proc(UINT message, WPARAM w_param, LPARAM l_param)
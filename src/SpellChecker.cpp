@@ -33,14 +33,197 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "SuggestionsButton.h"
 #include "SciUtils.h"
 #include "utils/string_utils.h"
+#include "utils/unicode.h"
 #include "Settings.h"
 #include "npp/EditorInterface.h"
 #include "npp/NppInterface.h"
 
+// Background suggestion search stops after that, lists found by then are not cached
+static constexpr auto suggestions_time_budget = 2s;
+
+static void apply_conversions(const Settings& settings, std::wstring& word) {
+    for (auto& c : word) {
+        if (settings.ignore_yo) {
+            if (c == L'')
+                c = L'';
+            if (c == L'')
+                c = L'';
+        }
+        if (settings.convert_single_quotes) {
+            if (c == L'')
+                c = L'\'';
+        }
+    }
+}
+
+static void cut_apostrophes(const Settings& settings, std::wstring_view& word) {
+    if (settings.remove_boundary_apostrophes) {
+        while (!word.empty() && word.front() == L'\'')
+            word.remove_prefix(1);
+
+        while (!word.empty() && word.back() == L'\'')
+            word.remove_suffix(1);
+    }
+}
+
+static std::shared_ptr<const CharClassTable> create_char_class_table(const Settings& settings) {
+    switch (settings.tokenization_style) {
+    case TokenizationStyle::by_non_alphabetic:
+        return std::make_shared<CharClassTable>([&settings](wchar_t c)
+        {
+            return !unicode_is_alnum(c) && settings.delimiter_exclusions.find(c) == std::wstring_view::npos;
+        }, settings.split_camel_case);
+    case TokenizationStyle::by_delimiters:
+        {
+            auto delimiters = L" \n\r\t\v" + parse_string(settings.delimiters.c_str());
+            return std::make_shared<CharClassTable>([&delimiters](wchar_t c)
+            {
+                return delimiters.find(c) != std::wstring::npos;
+            }, settings.split_camel_case);
+        }
+    case TokenizationStyle::COUNT: break;
+    }
+    assert (false);
+    return nullptr;
+}
+
+static bool is_word_ignored(const Settings& settings, const std::wstring& word) {
+    auto symbols_num = word.length();
+    if (symbols_num == 0) {
+        return true;
+    }
+
+    if (settings.ignore_one_letter && symbols_num == 1) {
+        return true;
+    }
+
+    // Well Numbers have same codes for ANSI and Unicode I guess, so
+    // If word contains number then it's probably just a number or some crazy name
+    if (settings.ignore_containing_digit &&
+        wcspbrk(word.c_str(), L"0123456789") != nullptr) // Same for UTF-8 and not
+    {
+        return true;
+    }
+
+    if (settings.ignore_starting_with_capital || settings.ignore_having_a_capital || settings.ignore_all_capital
+    ) {
+        if (settings.ignore_starting_with_capital && unicode_is_upper(word.front())) {
+            return true;
+        }
+        if (settings.ignore_having_a_capital || settings.ignore_all_capital) {
+            bool all_upper = unicode_is_upper(word.front()), any_upper = false;
+            for (auto c : std::wstring_view(word).substr(1)) {
+                if (unicode_is_upper(c)) {
+                    any_upper = true;
+                }
+                else
+                    all_upper = false;
+            }
+
+            if (!all_upper && any_upper && settings.ignore_having_a_capital)
+                return true;
+
+            if (all_upper && settings.ignore_all_capital)
+                return true;
+        }
+    }
+
+    if (settings.ignore_having_underscore && wcschr(word.c_str(), L'_') != nullptr)
+        // I guess the same for UTF-8 and ANSI
+    {
+        return true;
+    }
+
+    auto len = word.length();
+
+    if (settings.ignore_starting_or_ending_with_apostrophe) {
+        if (word[0] == '\'' || word[len - 1] == '\'') {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static std::vector<std::pair<long, long>> merge_ranges(std::vector<std::pair<long, long>> ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<long, long>> merged;
+    for (auto& range : ranges) {
+        if (!merged.empty() && range.first <= merged.back().second)
+            merged.back().second = std::max(merged.back().second, range.second);
+        else
+            merged.push_back(range);
+    }
+    return merged;
+}
+
+// Runs on worker thread so it uses only snapshots of settings and text, speller is used only under lock taken by
+// lock_speller, on GUI thread it should cancel suggestion prefetch instead of waiting for it
+static std::vector<Misspelling> find_all_misspellings(const Settings& settings, const CharClassTable& char_classes,
+                                                      SpellerInterface& speller,
+                                                      const std::function<std::unique_lock<std::mutex>()>& lock_speller,
+                                                      std::string_view text, bool is_utf8,
+                                                      const concurrency::cancellation_token& ctoken) {
+    // Chunks end at line ends since those are always word boundaries
+    constexpr size_t chunk_size = 64 * 1024;
+    std::vector<Misspelling> misspellings;
+    std::unordered_map<std::wstring, bool> verdicts;
+    size_t chunk_start = 0;
+    while (chunk_start < text.length()) {
+        if (ctoken.is_canceled())
+            return {};
+
+        auto chunk_end = text.find('\n', std::min(chunk_start + chunk_size, text.length()));
+        chunk_end = chunk_end != std::string_view::npos ? chunk_end + 1 : text.length();
+        auto chunk = text.substr(chunk_start, chunk_end - chunk_start);
+        auto mapped = is_utf8 ? utf8_to_mapped_wstring(chunk) : to_mapped_wstring(chunk);
+        std::vector<std::pair<std::wstring_view, std::wstring>> candidates;
+        for (auto token : TableTokenizer(mapped.str, char_classes)) {
+            cut_apostrophes(settings, token);
+            if (token.empty())
+                continue;
+
+            std::wstring word(token);
+            apply_conversions(settings, word);
+            if (!is_word_ignored(settings, word))
+                candidates.emplace_back(token, std::move(word));
+        }
+
+        {
+            auto lock = lock_speller();
+            // Speller might have been reconfigured while we were waiting
+            if (ctoken.is_canceled())
+                return {};
+
+            for (auto& [token, word] : candidates) {
+                auto it = verdicts.find(word);
+                if (it == verdicts.end())
+                    it = verdicts.emplace(word, speller.check_word(word.c_str())).first;
+                if (it->second)
+                    continue;
+
+                auto index = static_cast<long>(token.data() - mapped.str.data());
+                misspellings.push_back({
+                    static_cast<long>(chunk_start) + mapped.to_original_index(index),
+                    static_cast<long>(chunk_start) + mapped.to_original_index(index + static_cast<long>(token.length())),
+                    std::wstring(token)
+                });
+            }
+        }
+        chunk_start = chunk_end;
+    }
+    return misspellings;
+}
+
 SpellChecker::SpellChecker(NppData* npp_data_instance_arg,
                            SuggestionsButton* suggestions_instance_arg,
                            const Settings* settings,
-                           EditorInterface &editor) : m_settings(*settings), m_editor (editor) {
+                           EditorInterface &editor) : m_settings(*settings), m_editor (editor),
+                                                      m_suggestion_cache(std::make_shared<SuggestionCache>()),
+                                                      m_speller_mutex(std::make_shared<std::mutex>()),
+                                                      m_document_check_task(npp_data_instance_arg->npp_handle),
+                                                      m_suggestions_prefetch_task(npp_data_instance_arg->npp_handle),
+                                                      m_complete_suggestions_task(npp_data_instance_arg->npp_handle) {
     m_current_position = 0;
     m_suggestions_instance = suggestions_instance_arg;
     m_npp_data_instance = npp_data_instance_arg;
@@ -50,8 +233,9 @@ SpellChecker::SpellChecker(NppData* npp_data_instance_arg,
     m_aspell_speller = std::make_unique<AspellInterface>(m_npp_data_instance->npp_handle);
     m_hunspell_speller = std::make_unique<HunspellInterface>(m_npp_data_instance->npp_handle);
     m_current_speller = m_aspell_speller.get();
-    reset_hot_spot_cache();
     m_settings.settings_changed.connect([this] { on_settings_changed(); });
+    m_hunspell_speller->dictionary_loaded.connect([this] { on_dictionary_loaded(); });
+    update_char_classes();
     auto npp = dynamic_cast<NppInterface *> (&m_editor);
     if (!npp)
         return;
@@ -67,6 +251,7 @@ SpellChecker::SpellChecker(NppData* npp_data_instance_arg,
 }
 
 SpellChecker::~SpellChecker() {
+    stop_document_check();
 }
 
 void insert_sugg_menu_item(HMENU menu, const wchar_t* text, BYTE id, int insert_pos,
@@ -106,6 +291,17 @@ void SpellChecker::precalculate_menu() {
         }
     }
     show_calculated_menu(std::move(suggestion_menu_items));
+    on_suggestions_menu_closed();
+}
+
+void SpellChecker::set_open_suggestions_menu(HMENU menu) {
+    m_open_suggestions_menu = menu;
+}
+
+void SpellChecker::on_suggestions_menu_closed() {
+    // Chosen item refers to suggestions which were shown
+    m_complete_suggestions_task.cancel();
+    m_open_suggestions_menu = nullptr;
 }
 
 int SpellChecker::get_aspell_status() {
@@ -119,6 +315,14 @@ void SpellChecker::recheck_visible_both_views() {
     recheck_visible(EditorViewType::secondary);
 }
 
+void SpellChecker::recheck_modified_both_views() {
+    auto view = m_editor.active_view();
+    recheck_modified(view);
+    auto other_view = EditorInterface::other_view(view);
+    if (!m_modified_ranges[other_view].empty())
+        recheck_modified(other_view);
+}
+
 const SpellerInterface* SpellChecker::active_speller() const {
     switch (m_settings.active_speller_lib_id) {
     case SpellerId::aspell:
@@ -132,6 +336,7 @@ const SpellerInterface* SpellChecker::active_speller() const {
 void SpellChecker::show_suggestion_menu() {
     fill_suggestions_menu(m_suggestions_instance->get_popup_menu());
     SendMessage(m_suggestions_instance->getHSelf(), WM_SHOWANDRECREATEMENU, 0, 0);
+    on_suggestions_menu_closed();
 }
 
 void SpellChecker::lang_change() {
@@ -235,6 +440,9 @@ bool SpellChecker::check_text_needed() {
 void SpellChecker::hide_suggestion_box() { m_suggestions_instance->display(false); }
 
 void SpellChecker::find_next_mistake() {
+    if (find_mistake_in_document_check_results(true))
+        return;
+
     auto view = m_editor.active_view();
     m_current_position = m_editor.get_current_pos(view);
     auto cur_line = m_editor.line_from_position(view, m_current_position);
@@ -251,7 +459,7 @@ void SpellChecker::find_next_mistake() {
             ignore_offsetting = 1;
             to = static_cast<long>(doc_length);
         }
-        auto text = to_mapped_wstring (view, m_editor.get_text_range(view, from, to).c_str ());
+        auto text = to_mapped_wstring (view, m_editor.get_text_range_view(view, from, to));
         auto index = prev_token_begin(text.str, static_cast<long> (text.str.size()) - 1).value_or(text.str.size() - 1);
         text.str.data()[index] = L'\0';
         m_editor.force_style_update(view, from, to);
@@ -282,7 +490,10 @@ void SpellChecker::find_next_mistake() {
 }
 
 void SpellChecker::find_prev_mistake() {
-    auto view = m_editor.active_view(); 
+    if (find_mistake_in_document_check_results(false))
+        return;
+
+    auto view = m_editor.active_view();
     m_current_position = m_editor.get_current_pos(view);
     auto cur_line = m_editor.line_from_position(view, m_current_position);
     auto doc_length = m_editor.get_active_document_length(view);
@@ -300,7 +511,7 @@ void SpellChecker::find_prev_mistake() {
             ignore_offsetting = 1;
         }
 
-        auto text = to_mapped_wstring(view, m_editor.get_text_range(view, from, to));
+        auto text = to_mapped_wstring(view, m_editor.get_text_range_view(view, from, to));
         auto offset = next_token_end(text.str, 0).value_or(0);
         m_editor.force_style_update(view, from + offset, to);
         SCNotification scn;
@@ -330,6 +541,46 @@ void SpellChecker::find_prev_mistake() {
     }
 }
 
+bool SpellChecker::find_mistake_in_document_check_results(bool forward) {
+    auto view = m_editor.active_view();
+    auto document_misspellings = current_document_misspellings(view);
+    if (!document_misspellings)
+        return false;
+
+    auto position = m_editor.get_current_pos(view);
+    auto try_select = [&](const Misspelling& misspelling)
+    {
+        // Results are not filtered by style since it's unknown to background check
+        m_editor.force_style_update(view, misspelling.start, misspelling.end);
+        if (is_style_skipped(view, misspelling.start))
+            return false;
+
+        m_editor.set_selection(view, misspelling.start, misspelling.end);
+        return true;
+    };
+    auto& misspellings = document_misspellings->get();
+    if (forward) {
+        auto it = document_misspellings->first_ending_after(position);
+        for (auto cur = it; cur != misspellings.end(); ++cur)
+            if (try_select(*cur))
+                return true;
+        for (auto cur = misspellings.begin(); cur != it; ++cur)
+            if (try_select(*cur))
+                return true;
+    }
+    else {
+        auto it = std::make_reverse_iterator(document_misspellings->first_ending_not_before(position));
+        for (auto cur = it; cur != misspellings.rend(); ++cur)
+            if (try_select(*cur))
+                return true;
+        for (auto cur = misspellings.rbegin(); cur != it; ++cur)
+            if (try_select(*cur))
+                return true;
+    }
+    // Whole document was considered, nothing to find
+    return true;
+}
+
 bool SpellChecker::is_word_under_cursor_correct(long& pos, long& length,
                                                   bool use_text_cursor) {
     bool ret = true;
@@ -364,7 +615,7 @@ bool SpellChecker::is_word_under_cursor_correct(long& pos, long& length,
             ret = true;
         }
         else {
-            cut_apostrophes(word);
+            cut_apostrophes(m_settings, word);
             pos = static_cast<long>(
                 mapped_str.to_original_index(static_cast<long> (word.data() - mapped_str.str.data())) + offset
             );
@@ -375,7 +626,7 @@ bool SpellChecker::is_word_under_cursor_correct(long& pos, long& length,
                 (selection_start != pos || selection_end != pos + word_len)) {
                 return true;
             }
-            if (check_word(view, std::wstring(word), pos, pos + word_len - 1)) {
+            if (is_style_skipped(view, pos) || check_word(std::wstring(word))) {
                 ret = true;
             }
             else {
@@ -481,15 +732,23 @@ void SpellChecker::process_menu_result(WPARAM menu_id) {
 
             if (result != 0) {
                 if (result == MID_IGNOREALL) {
-                    apply_conversions(m_selected_word.str);
+                    stop_document_check();
+                    apply_conversions(m_settings, m_selected_word.str);
+                    m_current_speller->select_dictionary(m_last_suggestions_dictionary);
                     m_current_speller->ignore_all(m_selected_word.str.c_str());
+                    m_verdict_cache.invalidate(m_selected_word.str);
+                    clear_suggestion_cache();
                     m_word_under_cursor_length = static_cast<long> (m_selected_word.str.length());
                     m_editor.set_cursor_pos(view, m_word_under_cursor_pos + m_word_under_cursor_length);
                     recheck_visible_both_views();
                 }
                 else if (result == MID_ADDTODICTIONARY) {
-                    apply_conversions(m_selected_word.str);
+                    stop_document_check();
+                    apply_conversions(m_settings, m_selected_word.str);
+                    m_current_speller->select_dictionary(m_last_suggestions_dictionary);
                     m_current_speller->add_to_dictionary(m_selected_word.str.c_str());
+                    m_verdict_cache.invalidate(m_selected_word.str);
+                    clear_suggestion_cache();
                     m_word_under_cursor_length = static_cast<long> (m_selected_word.str.length());
                     m_editor.set_cursor_pos(view, m_word_under_cursor_pos + m_word_under_cursor_length);
                     recheck_visible_both_views();
@@ -547,9 +806,28 @@ std::vector<SuggestionsMenuItem> SpellChecker::fill_suggestions_menu(HMENU menu)
     auto text = m_editor.get_text_range(view, m_word_under_cursor_pos, m_word_under_cursor_pos + static_cast<long>(m_word_under_cursor_length));
 
     m_selected_word = to_mapped_wstring(view, text.data ());
-    apply_conversions(m_selected_word.str);
+    apply_conversions(m_settings, m_selected_word.str);
 
-    m_last_suggestions = m_current_speller->get_suggestions(m_selected_word.str.c_str());
+    bool complete = true;
+    {
+        auto lock = lock_speller();
+        // Usually prefetched already
+        if (auto suggestions = m_suggestion_cache->find(m_selected_word.str)) {
+            m_last_suggestions = suggestions->suggestions;
+            m_last_suggestions_dictionary = suggestions->dictionary;
+        }
+        else
+            complete = false;
+    }
+    if (!complete) {
+        // Search below shouldn't wait for prefetch of other words
+        m_suggestions_prefetch_task.cancel();
+        // Menu doesn't wait for slow search, fast suggestions are shown while the same search continues in background
+        SuggestionList suggestions;
+        std::tie(suggestions, complete) = start_complete_suggestions(m_selected_word.str).get();
+        m_last_suggestions = std::move(suggestions.suggestions);
+        m_last_suggestions_dictionary = suggestions.dictionary;
+    }
 
     for (int i = 0; i < static_cast<int>(m_last_suggestions.size()); i++) {
         if (i >= m_settings.suggestion_count)
@@ -569,7 +847,7 @@ std::vector<SuggestionsMenuItem> SpellChecker::fill_suggestions_menu(HMENU menu)
             suggestion_menu_items.emplace_back(L"", 0, true);
     }
 
-    apply_conversions(m_selected_word.str);
+    apply_conversions(m_settings, m_selected_word.str);
     auto menu_string = wstring_printf(L"Ignore \"%s\" for Current Session", m_selected_word.str.c_str());
     if (m_settings.suggestions_mode == SuggestionMode::button)
         insert_sugg_menu_item(menu, menu_string.c_str(), MID_IGNOREALL, -1);
@@ -584,9 +862,77 @@ std::vector<SuggestionsMenuItem> SpellChecker::fill_suggestions_menu(HMENU menu)
     if (m_settings.suggestions_mode == SuggestionMode::context_menu)
         suggestion_menu_items.emplace_back(L"", 0, true);
 
+    // Context menu is known only when it's shown
+    m_open_suggestions_menu = menu;
+
     return suggestion_menu_items;
 }
 
+size_t SpellChecker::max_suggestion_count() const {
+    return static_cast<size_t>(std::max(m_settings.suggestion_count, 0));
+}
+
+std::future<std::pair<SuggestionList, bool>> SpellChecker::start_complete_suggestions(std::wstring word) {
+    auto first = std::make_shared<std::promise<std::pair<SuggestionList, bool>>>();
+    auto first_future = first->get_future();
+    m_complete_suggestions_task.do_deferred(
+        [speller = m_current_speller, speller_mutex = m_speller_mutex, suggestion_cache = m_suggestion_cache,
+            word = std::move(word), max_count = max_suggestion_count(), first](const concurrency::cancellation_token& ctoken)
+            -> std::optional<SuggestionList>
+        {
+            std::lock_guard<std::mutex> lock(*speller_mutex);
+            bool fast_tier_sent = false;
+            auto deadline = std::chrono::steady_clock::now() + suggestions_time_budget;
+            SuggestionList suggestions;
+            suggestions.suggestions = speller->get_suggestions(word.c_str(), max_count, deadline, ctoken,
+                [&](const std::vector<std::wstring>& tier)
+                {
+                    first->set_value({{tier, speller->get_selected_dictionary()}, false});
+                    fast_tier_sent = true;
+                });
+            suggestions.dictionary = speller->get_selected_dictionary();
+            // Cut short lists are not cached
+            if (!ctoken.is_canceled() && std::chrono::steady_clock::now() < deadline && !speller->is_loading())
+                suggestion_cache->store(word, suggestions);
+            if (!fast_tier_sent) {
+                // Menu is still waiting, there's nothing to update
+                first->set_value({std::move(suggestions), true});
+                return std::nullopt;
+            }
+            return suggestions;
+        },
+        [this](const std::optional<SuggestionList>& suggestions)
+        {
+            if (suggestions)
+                update_suggestions_menu(*suggestions);
+        });
+    return first_future;
+}
+
+void SpellChecker::update_suggestions_menu(const SuggestionList& suggestions) {
+    auto shown_count = [this]
+    {
+        return std::min(static_cast<int>(m_last_suggestions.size()), m_settings.suggestion_count);
+    };
+    // Item ids are indices in the list, it's replaced only together with the items so a choice made in the menu
+    // couldn't pick a word of the other list
+    if (!m_open_suggestions_menu)
+        return;
+
+    // Suggestions are the first items of the menu, followed by a separator if there are any
+    int old_count = shown_count();
+    bool had_separator = !m_last_suggestions.empty();
+    m_last_suggestions = suggestions.suggestions;
+    m_last_suggestions_dictionary = suggestions.dictionary;
+    for (int i = 0; i < old_count + (had_separator ? 1 : 0); ++i)
+        DeleteMenu(m_open_suggestions_menu, 0, MF_BYPOSITION);
+    int count = shown_count();
+    for (int i = 0; i < count; ++i)
+        insert_sugg_menu_item(m_open_suggestions_menu, m_last_suggestions[i].c_str(), static_cast<BYTE>(i + 1), i);
+    if (!m_last_suggestions.empty())
+        insert_sugg_menu_item(m_open_suggestions_menu, L"", 0, count, true);
+}
+
 void SpellChecker::refresh_underline_style() {
     for (auto view : enum_range<EditorViewType> ())
         {
@@ -596,6 +942,7 @@ void SpellChecker::refresh_underline_style() {
 }
 
 void SpellChecker::init_speller() {
+    stop_document_check();
     switch (m_settings.active_speller_lib_id) {
 
     case SpellerId::aspell:
@@ -607,9 +954,15 @@ void SpellChecker::init_speller() {
         hunspell_reinit_settings(false);
         break;
     }
+    auto language_set = m_settings.get_current_language() + L"|" + m_settings.get_current_multi_languages();
+    m_verdict_cache.set_context(m_current_speller, language_set);
+    auto lock = lock_speller();
+    m_suggestion_cache->set_context(m_current_speller, std::move(language_set), max_suggestion_count());
 }
 
 void SpellChecker::on_settings_changed() {
+    stop_document_check();
+    update_char_classes();
     m_hunspell_speller->set_use_one_dic(m_settings.use_unified_dictionary);
     {
         auto npp = dynamic_cast<NppInterface *> (&m_editor);
@@ -628,22 +981,35 @@ void SpellChecker::on_settings_changed() {
     refresh_underline_style();
     recheck_visible_both_views();
     do_plugin_menu_inclusion();
-    update_delimiters();
     get_download_dics()->update_list_box();
     speller_status_changed();
 }
 
-void SpellChecker::create_word_underline(EditorViewType view,
-                                         long start, long end) {
-    m_editor.set_current_indicator(view, SCE_ERROR_UNDERLINE);
-    m_editor.indicator_fill_range(view, start, end);
+void SpellChecker::on_dictionary_loaded() {
+    if (m_current_speller != m_hunspell_speller.get())
+        return;
+
+    // Words checked while dictionary was loading were accepted without being checked
+    stop_document_check();
+    m_verdict_cache.clear();
+    clear_suggestion_cache();
+    recheck_visible_both_views();
 }
 
-void SpellChecker::remove_underline(EditorViewType view, long start, long end) {
-    if (end < start)
+void SpellChecker::apply_underlines(EditorViewType view, long from, long to,
+                                    const std::vector<std::pair<long, long>>& underlines) {
+    auto changes = m_painted_underlines[view].update(from, to, underlines);
+    if (changes.empty())
         return;
-    m_editor.set_current_indicator(view, SCE_ERROR_UNDERLINE);
-    m_editor.indicator_clear_range(view, start, end);
+
+    m_editor.apply_indicator_ranges(view, SCE_ERROR_UNDERLINE, changes);
+    // Other view might show the same document
+    m_painted_underlines[EditorInterface::other_view(view)].forget();
+}
+
+void SpellChecker::forget_painted_underlines() {
+    for (auto view : enum_range<EditorViewType>())
+        m_painted_underlines[view].forget();
 }
 
 void SpellChecker::get_visible_limits(EditorViewType view, long& start, long& finish) {
@@ -683,15 +1049,16 @@ MappedWstring SpellChecker::get_visible_text(EditorViewType view, long* offset,
             from = m_previous_b + 1;
     }
     *offset = from;
-    return to_mapped_wstring(view, m_editor.get_text_range(view, from, to));
+    return to_mapped_wstring(view, m_editor.get_text_range_view(view, from, to));
 }
 
 void SpellChecker::clear_all_underlines(EditorViewType view) {
 
     auto length = m_editor.get_active_document_length(view);
     if (length > 0) {
-        m_editor.set_current_indicator(view, SCE_ERROR_UNDERLINE);
-        m_editor.indicator_clear_range(view, 0, length - 1);
+        m_editor.apply_indicator_ranges(view, SCE_ERROR_UNDERLINE, {{0, length, false}});
+        m_painted_underlines[view].set_all_cleared();
+        m_painted_underlines[EditorInterface::other_view(view)].forget();
     }
 }
 
@@ -727,6 +1094,7 @@ void SpellChecker::update_hunspell_language_options() {
 }
 
 bool SpellChecker::hunspell_reinit_settings(bool reset_directory) {
+    stop_document_check();
     if (reset_directory) {
         m_hunspell_speller->set_directory(m_settings.hunspell_user_path.c_str());
         m_hunspell_speller->set_additional_directory(m_settings.hunspell_system_path.c_str());
@@ -735,10 +1103,14 @@ bool SpellChecker::hunspell_reinit_settings(bool reset_directory) {
         m_hunspell_speller->set_language(m_settings.hunspell_language.c_str());
     else
         set_multiple_languages(m_settings.hunspell_multi_languages.c_str(), m_hunspell_speller.get());
+    // Dictionaries might have been reloaded from disk, verdicts for the same languages could be different now
+    m_verdict_cache.clear();
+    clear_suggestion_cache();
     return true;
 }
 
 bool SpellChecker::aspell_reinit_settings() {
+    stop_document_check();
     m_aspell_speller->init(m_settings.aspell_path.c_str());
     m_aspell_speller->set_allow_run_together(m_settings.aspell_allow_run_together_words);
 
@@ -747,6 +1119,8 @@ bool SpellChecker::aspell_reinit_settings() {
     }
     else
         set_multiple_languages(m_settings.aspell_multi_languages, m_aspell_speller.get());
+    m_verdict_cache.clear();
+    clear_suggestion_cache();
     return true;
 }
 
@@ -757,104 +1131,70 @@ void SpellChecker::update_suggestion_box() {
                                LWA_ALPHA);
 }
 
-void SpellChecker::apply_conversions(
-    std::wstring& word) {
-    for (auto& c : word) {
-        if (m_settings.ignore_yo) {
-            if (c == L'')
-                c = L'';
-            if (c == L'')
-                c = L'';
-        }
-        if (m_settings.convert_single_quotes) {
-            if (c == L'')
-                c = L'\'';
-        }
-    }
-}
-
-void SpellChecker::reset_hot_spot_cache() {
-    memset(m_hot_spot_cache, -1, sizeof(m_hot_spot_cache));
-}
-
-bool SpellChecker::check_word(EditorViewType view, std::wstring word, long start, long /*End*/) {
+bool SpellChecker::check_word(std::wstring word) {
     if (!m_current_speller->is_working() || word.empty())
         return true;
-    // Well Numbers have same codes for ANSI and Unicode I guess, so
-    // If word contains number then it's probably just a number or some crazy name
-    auto style = m_editor.get_style_at (view, start);
-    if (m_settings.check_only_comments_and_strings && !SciUtils::is_comment_or_string(m_editor.get_lexer(view), style))
-        return true;
-
-    if (m_editor.is_style_hotspot(view, style))
-        return true;
 
-    apply_conversions(word);
-
-    auto symbols_num = word.length();
-    if (symbols_num == 0) {
+    apply_conversions(m_settings, word);
+    if (is_word_ignored(m_settings, word))
         return true;
-    }
 
-    if (m_settings.ignore_one_letter && symbols_num == 1) {
-        return true;
-    }
+    if (auto verdict = m_verdict_cache.find(word))
+        return *verdict;
 
-    if (m_settings.ignore_containing_digit &&
-        wcspbrk(word.c_str(), L"0123456789") != nullptr) // Same for UTF-8 and not
+    bool res;
+    bool loading;
     {
-        return true;
+        auto lock = lock_speller();
+        res = m_current_speller->check_word(word.c_str());
+        loading = m_current_speller->is_loading();
     }
+    if (!loading)
+        m_verdict_cache.store(std::move(word), res);
+    return res;
+}
 
-    if (m_settings.ignore_starting_with_capital || m_settings.ignore_having_a_capital || m_settings.ignore_all_capital
-    ) {
-        if (m_settings.ignore_starting_with_capital && IsCharUpper(word.front())) {
-            return true;
-        }
-        if (m_settings.ignore_having_a_capital || m_settings.ignore_all_capital) {
-            bool all_upper = IsCharUpper(word.front()), any_upper = false;
-            for (auto c : std::wstring_view(word).substr(1)) {
-                if (IsCharUpper(c)) {
-                    any_upper = true;
-                }
-                else
-                    all_upper = false;
-            }
-
-            if (!all_upper && any_upper && m_settings.ignore_having_a_capital)
-                return true;
-
-            if (all_upper && m_settings.ignore_all_capital)
-                return true;
-        }
-    }
+bool SpellChecker::is_style_skipped(EditorViewType view, long position) {
+    return is_skipped_style(view, m_editor.get_style_at(view, position));
+}
 
-    if (m_settings.ignore_having_underscore && wcschr(word.c_str(), L'_') != nullptr)
-        // I guess the same for UTF-8 and ANSI
-    {
+bool SpellChecker::is_skipped_style(EditorViewType view, int style) {
+    if (m_settings.check_only_comments_and_strings && !SciUtils::comment_or_string_styles(m_editor.get_lexer(view))[style])
         return true;
-    }
 
-    auto len = word.length();
-
-    if (m_settings.ignore_starting_or_ending_with_apostrophe) {
-        if (word[0] == '\'' || word[len - 1] == '\'') {
-            return true;
-        }
-    }
-
-    bool res = m_current_speller->check_word(word.c_str());
-    return res;
+    return m_editor.is_style_hotspot(view, style);
 }
 
-void SpellChecker::cut_apostrophes(std::wstring_view& word) {
-    if (m_settings.remove_boundary_apostrophes) {
-        while (!word.empty() && word.front() == L'\'')
-            word.remove_prefix(1);
+std::vector<std::wstring_view> SpellChecker::get_checked_style_runs(EditorViewType view, const MappedWstring& text,
+                                                                    long offset, size_t skip_chars) {
+    auto text_len = static_cast<long>(text.str.length());
+    auto first = static_cast<long>(skip_chars);
+    if (first >= text_len)
+        return {};
 
-        while (!word.empty() && word.back() == L'\'')
-            word.remove_suffix(1);
+    auto from = offset + text.to_original_index(first);
+    auto styles = m_editor.get_styles(view, from, offset + text.to_original_index(text_len));
+    // Each style is classified once, text is then split into runs of checked styles
+    std::array<signed char, 256> skipped;
+    skipped.fill(-1);
+    std::vector<std::wstring_view> runs;
+    long run_start = -1;
+    for (long i = first; i < text_len; ++i) {
+        auto style_index = offset + text.to_original_index(i) - from;
+        auto style = style_index < static_cast<long>(styles.size()) ? styles[style_index] : 0;
+        if (skipped[style] < 0)
+            skipped[style] = is_skipped_style(view, style) ? 1 : 0;
+        if (skipped[style] != 0) {
+            if (run_start >= 0)
+                runs.emplace_back(text.str.data() + run_start, i - run_start);
+            run_start = -1;
+        }
+        else if (run_start < 0)
+            run_start = i;
     }
+    if (run_start >= 0)
+        runs.emplace_back(text.str.data() + run_start, text_len - run_start);
+    return runs;
 }
 
 std::vector<LanguageInfo> SpellChecker::get_available_languages() const {
@@ -866,41 +1206,13 @@ std::vector<LanguageInfo> SpellChecker::get_available_languages() const {
     return langs;
 }
 
-auto SpellChecker::non_alphabetic_tokenizer(std::wstring_view target) const {
-    return make_condition_tokenizer(target, [this](wchar_t c)
-    {
-        return !IsCharAlphaNumeric(c) && m_settings.delimiter_exclusions.find(c) == std
-            ::wstring_view::npos;
-    }, m_settings.split_camel_case);
-}
-
-auto SpellChecker::delimiter_tokenizer(std::wstring_view target) const {
-    return make_delimiter_tokenizer(target, m_settings.delimiters, m_settings.split_camel_case);
-}
-
 std::optional<long> SpellChecker::next_token_end(std::wstring_view target, long index) const {
-    switch (m_settings.tokenization_style) {
-    case TokenizationStyle::by_non_alphabetic:
-        return non_alphabetic_tokenizer(target).next_token_end(index);
-    case TokenizationStyle::by_delimiters:
-        return delimiter_tokenizer(target).next_token_end(index);
-    case TokenizationStyle::COUNT: break;
-    }
-    assert (false);
-    return std::nullopt;
+    return TableTokenizer(target, *m_char_classes).next_token_end(index);
 }
 
 
 std::optional<long> SpellChecker::prev_token_begin(std::wstring_view target, long index) const {
-    switch (m_settings.tokenization_style) {
-    case TokenizationStyle::by_non_alphabetic:
-        return non_alphabetic_tokenizer(target).prev_token_begin(index);
-    case TokenizationStyle::by_delimiters:
-        return delimiter_tokenizer (target).prev_token_begin(index);
-    case TokenizationStyle::COUNT: break;
-    }
-    assert (false);
-    return std::nullopt;
+    return TableTokenizer(target, *m_char_classes).prev_token_begin(index);
 }
 
 int SpellChecker::check_text(EditorViewType view, const MappedWstring& text_to_check,
@@ -911,83 +1223,61 @@ int SpellChecker::check_text(EditorViewType view, const MappedWstring& text_to_c
     bool stop = false;
     long resulting_word_end = -1, resulting_word_start = -1;
     auto text_len = text_to_check.str.length();
-    std::vector<long> underline_buffer;
+    std::vector<std::pair<long, long>> underlines;
     long word_start = 0;
     long word_end = 0;
 
-    auto sv = std::wstring_view(text_to_check.str);
-    sv.remove_prefix(skip_chars);
-    std::vector<std::wstring_view> tokens;
-    switch (m_settings.tokenization_style) {
-    case TokenizationStyle::by_non_alphabetic:
-        tokens = non_alphabetic_tokenizer(sv).get_all_tokens();
-        break;
-    case TokenizationStyle::by_delimiters:
-        tokens = delimiter_tokenizer(sv).get_all_tokens();
-        break;
-    case TokenizationStyle::COUNT: break;
-    }
-
-    for (auto token : tokens) {
-        cut_apostrophes(token);
-        last_result = token;
-        word_start = static_cast<long>(offset + text_to_check.to_original_index(
-                static_cast<long> (token.data() - text_to_check.str.data()))
-        );
-        word_end = static_cast<long>(offset + text_to_check.to_original_index(
-            static_cast<long> (token.data() - text_to_check.str.data() + token.length())));
-        if (word_end < word_start)
-            continue;
-
-        if (!check_word(view, std::wstring(token), word_start, word_end)) {
-            switch (mode) {
-            case CheckTextMode::underline_errors:
-                underline_buffer.push_back(word_start);
-                underline_buffer.push_back(word_end);
-                break;
-            case CheckTextMode::find_first:
-                if (word_end > m_current_position) {
-                    m_editor.set_selection(view, word_start, word_end);
-                    stop = true;
-                }
-                break;
-            case CheckTextMode::find_last:
-                {
-                    if (word_end >= m_current_position) {
+    for (auto run : get_checked_style_runs(view, text_to_check, offset, skip_chars)) {
+        for (auto token : TableTokenizer(run, *m_char_classes)) {
+            cut_apostrophes(m_settings, token);
+            word_start = static_cast<long>(offset + text_to_check.to_original_index(
+                    static_cast<long> (token.data() - text_to_check.str.data()))
+            );
+            word_end = static_cast<long>(offset + text_to_check.to_original_index(
+                static_cast<long> (token.data() - text_to_check.str.data() + token.length())));
+            if (word_end < word_start)
+                continue;
+
+            if (!check_word(std::wstring(token))) {
+                switch (mode) {
+                case CheckTextMode::underline_errors:
+                    underlines.emplace_back(word_start, word_end);
+                    m_underlined_words.emplace_back(word_start, token);
+                    break;
+                case CheckTextMode::find_first:
+                    if (word_end > m_current_position) {
+                        m_editor.set_selection(view, word_start, word_end);
                         stop = true;
-                        break;
                     }
-                    resulting_word_start = word_start;
-                    resulting_word_end = word_end;
+                    break;
+                case CheckTextMode::find_last:
+                    {
+                        if (word_end >= m_current_position) {
+                            stop = true;
+                            break;
+                        }
+                        resulting_word_start = word_start;
+                        resulting_word_end = word_end;
+                    }
+                    break;
                 }
-                break;
-            case CheckTextMode::get_first:
-                return true;
+                if (stop)
+                    break;
             }
-            if (stop)
-                break;
         }
+        if (stop)
+            break;
     }
 
-    if (mode == CheckTextMode::underline_errors) {
-        long prev_pos = offset;
-        for (long i = 0; i < (long)underline_buffer.size() - 1; i += 2) {
-            remove_underline(view, prev_pos, underline_buffer[i] - 1);
-            create_word_underline(view, underline_buffer[i],
-                                    underline_buffer[i + 1] - 1);
-            prev_pos = underline_buffer[i + 1];
-        }
-        remove_underline(view, prev_pos,
-                           offset + static_cast<long>(text_len) - 1);
-    }
+    if (mode == CheckTextMode::underline_errors)
+        apply_underlines(view, offset, offset + text_to_check.to_original_index(static_cast<long>(text_len)),
+                         underlines);
 
     switch (mode) {
     case CheckTextMode::underline_errors:
         return true;
     case CheckTextMode::find_first:
         return stop;
-    case CheckTextMode::get_first:
-        return false;
     case CheckTextMode::find_last:
         if (resulting_word_start == -1)
             return false;
@@ -1019,33 +1309,329 @@ void SpellChecker::recheck_visible(EditorViewType view, bool not_intersection_on
         return;
     }
 
+    // whole visible area is checked so there's no need to check modified parts of it afterwards
+    m_modified_ranges[view].clear();
+
     // to utf-8 or no
-    if (check_text_needed())
+    if (check_text_needed()) {
+        m_underlined_words.clear();
         check_visible(view, not_intersection_only);
+        auto& checked = m_checked_visible_ranges[view];
+        get_visible_limits(view, checked.first, checked.second);
+        start_document_check(view);
+        start_suggestions_prefetch(view);
+    }
     else
         clear_all_underlines(view);
 }
 
-void SpellChecker::copy_misspellings_to_clipboard() {
-    auto view = m_editor.active_view();
-    auto buf = m_editor.get_active_document_text(view);
-    auto mapped_str = to_mapped_wstring(view, buf.data());
-    std::wstring str;
-    size_t cur_offset = 0;
-    do {
-        auto res = check_text(view, mapped_str, 0, CheckTextMode::get_first, cur_offset);
-        if (res) {
-            str += last_result;
-            str += L"\n";
+void SpellChecker::on_text_modified(EditorViewType view, long position, long length, bool inserted) {
+    // Each view showing the document notifies about the modification, data of the view is shifted for each of them
+    // while data of the document only once
+    m_painted_underlines[view].on_text_modified(position, length, inserted);
+    if (!m_document_misspellings.empty() || !m_document_check_path.empty()) {
+        auto path = m_editor.get_full_current_path(view);
+        if (view == EditorViewType::primary || path != m_editor.get_full_current_path(EditorInterface::other_view(view))) {
+            auto it = m_document_misspellings.find(path);
+            if (it != m_document_misspellings.end())
+                it->second.on_text_modified(position, length, inserted);
+            else if (path == m_document_check_path)
+                m_document_check_modifications.push_back({position, length, inserted});
         }
+    }
+
+    constexpr size_t max_modified_ranges_count = 64;
+    auto& ranges = m_modified_ranges[view];
+    auto& checked = m_checked_visible_ranges[view];
+    auto shift = [&](long& pos)
+    {
+        if (inserted) {
+            if (pos >= position)
+                pos += length;
+        }
+        else {
+            if (pos >= position + length)
+                pos -= length;
+            else if (pos > position)
+                pos = position;
+        }
+    };
+    for (auto& range : ranges) {
+        shift(range.first);
+        shift(range.second);
+    }
+    shift(checked.first);
+    shift(checked.second);
+    ranges.emplace_back(position, inserted ? position + length : position);
+    if (ranges.size() > max_modified_ranges_count) {
+        // Too many separate modifications (replace all etc.), just cover all of them at once
+        auto from = std::min_element(ranges.begin(), ranges.end())->first;
+        auto to = std::max_element(ranges.begin(), ranges.end(), [](const auto& lhs, const auto& rhs)
+        {
+            return lhs.second < rhs.second;
+        })->second;
+        ranges = {{from, to}};
+    }
+}
+
+void SpellChecker::recheck_modified(EditorViewType view) {
+    if (m_modified_ranges[view].empty() || !m_current_speller->is_working() || !check_text_needed()) {
+        recheck_visible(view);
+        return;
+    }
+
+    long visible_from, visible_to;
+    get_visible_limits(view, visible_from, visible_to);
+    auto& checked = m_checked_visible_ranges[view];
+    if (checked.second <= visible_from || checked.first >= visible_to) {
+        // Viewport has moved away from the checked text
+        recheck_visible(view);
+        return;
+    }
+
+    auto ranges = std::move(m_modified_ranges[view]);
+    m_modified_ranges[view].clear();
+    // Text which came into view because of the edits (new line at the bottom, deleted lines, scrolling to the caret)
+    if (visible_from < checked.first)
+        ranges.emplace_back(visible_from, checked.first);
+    if (checked.second < visible_to)
+        ranges.emplace_back(checked.second, visible_to);
+    checked = {visible_from, visible_to};
+    std::vector<std::pair<long, long>> to_check;
+    for (auto [from, to] : ranges) {
+        // Lexer restyles text starting from modification point so it might have turned code after it into comment
+        // or vice versa
+        if (m_settings.check_only_comments_and_strings)
+            to = std::max(to, visible_to);
+        std::tie(from, to) = expand_to_lines(view, from, to);
+        from = std::max(from, visible_from);
+        to = std::min(to, visible_to);
+        if (from < to)
+            to_check.emplace_back(from, to);
+    }
+
+    m_underlined_words.clear();
+    for (auto [from, to] : merge_ranges(std::move(to_check)))
+        check_text(view, to_mapped_wstring(view, m_editor.get_text_range_view(view, from, to)), from,
+                   CheckTextMode::underline_errors);
+
+    start_document_check(view);
+    start_suggestions_prefetch(view);
+}
+
+std::pair<long, long> SpellChecker::expand_to_lines(EditorViewType view, long from, long to) {
+    // Line boundaries are always word boundaries too
+    auto last_line = m_editor.line_from_position(view, to);
+    from = m_editor.get_line_start_position(view, m_editor.line_from_position(view, from));
+    to = last_line + 1 < m_editor.get_document_line_count(view)
+             ? m_editor.get_line_start_position(view, last_line + 1)
+             : m_editor.get_active_document_length(view);
+    return {from, to};
+}
+
+DocumentMisspellings* SpellChecker::current_document_misspellings(EditorViewType view) {
+    auto it = m_document_misspellings.find(m_editor.get_full_current_path());
+    if (it == m_document_misspellings.end())
+        return nullptr;
+
+    auto& document_misspellings = it->second;
+    if (document_misspellings.get_dirty_ranges().empty())
+        return &document_misspellings;
+
+    // Dirty ranges are usually just a few recently edited lines so they're checked right away
+    std::vector<std::pair<long, long>> to_check;
+    for (auto [from, to] : document_misspellings.get_dirty_ranges())
+        to_check.push_back(expand_to_lines(view, from, to));
+
+    auto is_utf8 = m_editor.get_encoding(view) == EditorCodepage::utf8;
+    for (auto [from, to] : merge_ranges(std::move(to_check))) {
+        auto misspellings = find_all_misspellings(m_settings, *m_char_classes, *m_current_speller,
+                                                  [this] { return lock_speller(); },
+                                                  m_editor.get_text_range_view(view, from, to), is_utf8,
+                                                  concurrency::cancellation_token::none());
+        for (auto& misspelling : misspellings) {
+            misspelling.start += from;
+            misspelling.end += from;
+        }
+        document_misspellings.update_range(from, to, std::move(misspellings));
+    }
+    return &document_misspellings;
+}
+
+void SpellChecker::start_document_check(EditorViewType view) {
+    if (!m_settings.check_whole_document_in_background || view != m_editor.active_view() || !
+        m_current_speller->is_working())
+        return;
+
+    auto path = m_editor.get_full_current_path();
+    if (m_document_misspellings.count(path) != 0 || m_document_check_path == path)
+        return;
+
+    {
+        // Results would be incomplete, check is started again once dictionaries are loaded
+        auto lock = lock_speller();
+        if (m_current_speller->is_loading())
+            return;
+    }
+
+    // Forget results for documents which were closed
+    auto open_filenames = m_editor.get_open_filenames();
+    for (auto it = m_document_misspellings.begin(); it != m_document_misspellings.end();) {
+        if (std::find(open_filenames.begin(), open_filenames.end(), it->first) == open_filenames.end())
+            it = m_document_misspellings.erase(it);
         else
-            break;
+            ++it;
+    }
 
-        cur_offset = last_result.data () - mapped_str.str.data () + last_result.length ();
-        if (cur_offset >= mapped_str.str.length ())
-            break;
+    m_document_check_path = path;
+    m_document_check_modifications.clear();
+    auto settings = std::make_shared<Settings>(m_settings);
+    // Snapshot is destroyed on worker thread and shouldn't be connected to anything
+    settings->settings_changed.disconnect_all();
+    m_document_check_task.do_deferred(
+        [settings, char_classes = m_char_classes, speller = m_current_speller, speller_mutex = m_speller_mutex,
+            text = m_editor.get_active_document_text(view),
+            is_utf8 = m_editor.get_encoding(view) == EditorCodepage::utf8](
+        const concurrency::cancellation_token& ctoken)
+        {
+            return find_all_misspellings(*settings, *char_classes, *speller,
+                                         [&] { return std::unique_lock<std::mutex>(*speller_mutex); },
+                                         std::string_view(text.data(), text.size() - 1), is_utf8, ctoken);
+        },
+        [this, path](const std::vector<Misspelling>& misspellings)
+        {
+            DocumentMisspellings document_misspellings(misspellings);
+            // Results correspond to the snapshot so modifications made since then should be applied to them
+            for (auto& modification : m_document_check_modifications)
+                document_misspellings.on_text_modified(modification.position, modification.length,
+                                                       modification.inserted);
+            m_document_check_modifications.clear();
+            m_document_check_path.clear();
+            m_document_misspellings[path] = std::move(document_misspellings);
+        });
+}
+
+void SpellChecker::cancel_document_check() {
+    m_document_check_task.cancel();
+    m_document_check_path.clear();
+    m_document_check_modifications.clear();
+    m_document_misspellings.clear();
+}
+
+void SpellChecker::stop_document_check() {
+    cancel_document_check();
+    m_suggestions_prefetch_task.cancel();
+    m_complete_suggestions_task.cancel();
+    // Worker checks for cancellation after taking the lock, so after getting it once we know speller is not used anymore
+    std::lock_guard<std::mutex> lock(*m_speller_mutex);
+}
+
+void SpellChecker::start_suggestions_prefetch(EditorViewType view) {
+    constexpr size_t max_prefetched_words = 20;
+    auto underlined_words = std::move(m_underlined_words);
+    m_underlined_words.clear();
+    if (underlined_words.empty() || view != m_editor.active_view() || !m_current_speller->is_working())
+        return;
+
+    // Misspellings near the caret are the most likely to be right-clicked
+    auto caret = m_editor.get_current_pos(view);
+    std::stable_sort(underlined_words.begin(), underlined_words.end(), [caret](const auto& lhs, const auto& rhs)
+    {
+        return std::abs(lhs.first - caret) < std::abs(rhs.first - caret);
+    });
+
+    std::vector<std::wstring> words;
+    {
+        auto lock = lock_speller();
+        // Suggestions would be incomplete
+        if (m_current_speller->is_loading())
+            return;
+
+        for (auto& [pos, word] : underlined_words) {
+            apply_conversions(m_settings, word);
+            if (m_suggestion_cache->find(word) || std::find(words.begin(), words.end(), word) != words.end())
+                continue;
+
+            words.push_back(std::move(word));
+            if (words.size() == max_prefetched_words)
+                break;
+        }
+    }
+    if (words.empty())
+        return;
+
+    m_suggestions_prefetch_task.do_deferred(
+        [speller = m_current_speller, speller_mutex = m_speller_mutex, suggestion_cache = m_suggestion_cache,
+            words = std::move(words), max_count = max_suggestion_count()](const concurrency::cancellation_token& ctoken)
+        {
+            for (auto& word : words) {
+                // Lock is taken for each word, GUI thread cancels prefetch when it needs the lock
+                std::lock_guard<std::mutex> lock(*speller_mutex);
+                // Speller might have been reconfigured while we were waiting
+                if (ctoken.is_canceled())
+                    return false;
+
+                if (suggestion_cache->find(word))
+                    continue;
+
+                auto deadline = std::chrono::steady_clock::now() + suggestions_time_budget;
+                SuggestionList suggestions;
+                suggestions.suggestions = speller->get_suggestions(word.c_str(), max_count, deadline, ctoken, nullptr);
+                if (ctoken.is_canceled())
+                    return false;
+                suggestions.dictionary = speller->get_selected_dictionary();
+                if (std::chrono::steady_clock::now() < deadline)
+                    suggestion_cache->store(word, std::move(suggestions));
+            }
+            return true;
+        },
+        [](bool)
+        {
+        });
+}
+
+std::unique_lock<std::mutex> SpellChecker::lock_speller() {
+    std::unique_lock<std::mutex> lock(*m_speller_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        // Prefetch holds the lock for a whole suggestion search, it stops soon after cancellation
+        m_suggestions_prefetch_task.cancel();
+        lock.lock();
+    }
+    return lock;
+}
+
+void SpellChecker::clear_suggestion_cache() {
+    // Prefetch is stopped first so it couldn't store suggestions obtained before the change
+    m_suggestions_prefetch_task.cancel();
+    m_complete_suggestions_task.cancel();
+    std::lock_guard<std::mutex> lock(*m_speller_mutex);
+    m_suggestion_cache->clear();
+}
+
+std::vector<Misspelling> SpellChecker::get_all_misspellings(EditorViewType view) {
+    std::vector<Misspelling> misspellings;
+    if (auto document_misspellings = current_document_misspellings(view))
+        misspellings = document_misspellings->get();
+    else if (m_current_speller->is_working()) {
+        misspellings = find_all_misspellings(m_settings, *m_char_classes, *m_current_speller,
+                                             [this] { return lock_speller(); },
+                                             m_editor.get_active_document_text_view(view),
+                                             m_editor.get_encoding(view) == EditorCodepage::utf8,
+                                             concurrency::cancellation_token::none());
+    }
+    misspellings.erase(std::remove_if(misspellings.begin(), misspellings.end(), [&](const Misspelling& misspelling)
+    {
+        return is_style_skipped(view, misspelling.start);
+    }), misspellings.end());
+    return misspellings;
+}
+
+void SpellChecker::copy_misspellings_to_clipboard() {
+    std::wstring str;
+    for (auto& misspelling : get_all_misspellings(m_editor.active_view())) {
+        str += misspelling.word;
+        str += L"\n";
     }
-    while (true);
     const size_t len = (str.length() + 1) * 2;
     HGLOBAL h_mem = GlobalAlloc(GMEM_MOVEABLE, len);
     memcpy(GlobalLock(h_mem), str.c_str(), len);
@@ -1056,8 +1642,47 @@ void SpellChecker::copy_misspellings_to_clipboard() {
     CloseClipboard();
 }
 
-void SpellChecker::update_delimiters() {
-    m_delimiters = L" \n\r\t\v" + parse_string(m_settings.delimiters.c_str());
+void SpellChecker::export_misspellings_to_file() {
+    std::vector<wchar_t> filename(MAX_PATH);
+    OPENFILENAME ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = m_npp_data_instance->npp_handle;
+    ofn.lpstrFile = filename.data();
+    ofn.nMaxFile = static_cast<DWORD>(filename.size());
+    ofn.lpstrFilter = L"Text Files (*.txt)\0*.txt\0All Files (*.*)\0*.*\0";
+    ofn.nFilterIndex = 1;
+    ofn.lpstrDefExt = L"txt";
+    ofn.Flags = OFN_PATHMUSTEXIST | OFN_OVERWRITEPROMPT;
+    if (!GetSaveFileName(&ofn))
+        return;
+
+    auto words = count_misspelled_words(get_all_misspellings(m_editor.active_view()));
+    // Most frequent first, ties are kept in order of appearance
+    std::stable_sort(words.begin(), words.end(), [](const auto& lhs, const auto& rhs)
+    {
+        return lhs.second > rhs.second;
+    });
+    FILE* fp = _wfopen(filename.data(), L"wb");
+    if (!fp) {
+        MessageBox(m_npp_data_instance->npp_handle, L"Failed to open file for writing", L"Export Misspellings",
+                   MB_OK | MB_ICONEXCLAMATION);
+        return;
+    }
+
+    for (auto& [word, count] : words)
+        fprintf(fp, "%s\t%d\r\n", to_utf8_string(word).c_str(), count);
+    fclose(fp);
+}
+
+void SpellChecker::update_char_classes() {
+    auto key = std::make_tuple(m_settings.tokenization_style, m_settings.delimiters, m_settings.delimiter_exclusions,
+                               m_settings.split_camel_case);
+    // Table takes a while to build so it's rebuilt only if tokenization settings really changed
+    if (m_char_classes && key == m_char_classes_key)
+        return;
+    m_char_classes = create_char_class_table(m_settings);
+    m_char_classes_key = std::move(key);
 }
 
 SuggestionsMenuItem::SuggestionsMenuItem(const wchar_t* text_arg, int id_arg,
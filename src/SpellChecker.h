@@ -24,6 +24,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "lsignal.h"
 #include "CommonFunctions.h"
 #include "npp/EditorInterface.h"
+#include "WordVerdictCache.h"
+#include "SuggestionCache.h"
+#include "DocumentMisspellings.h"
+#include "PaintedUnderlines.h"
+#include "TaskWrapper.h"
+#include "utils/enum_array.h"
+
+#include <future>
+#include <mutex>
+#include <tuple>
 
 class EditorInterface;
 class Settings;
@@ -38,6 +48,8 @@ class AspellInterface;
 class HunspellInterface;
 class SelectProxy;
 class MappedWstring;
+class CharClassTable;
+enum class TokenizationStyle;
 
 struct SuggestionsMenuItem {
     std::wstring text;
@@ -57,8 +69,6 @@ class SpellChecker {
         underline_errors = 0,
         find_first = 1,
         find_last = 2,
-        get_first = 3,
-        // Returns position of first (for recurring usage)
     };
 
 public:
@@ -74,7 +84,18 @@ public:
     const SpellerInterface* active_speller() const;
     void show_suggestion_menu();
     void precalculate_menu();
+    // Context menu showing suggestions, they are updated in it while it's open
+    void set_open_suggestions_menu(HMENU menu);
     void recheck_visible(EditorViewType view, bool not_intersection_only = false);
+    void on_text_modified(EditorViewType view, long position, long length, bool inserted);
+    void recheck_modified(EditorViewType view);
+    // Rechecks modified text of the active view and of the other one if it shows the modified document too
+    void recheck_modified_both_views();
+    // Should be called before reconfiguring spellers so background check and suggestion prefetch wouldn't use them
+    // meanwhile
+    void stop_document_check();
+    // Should be called when view might show different document now
+    void forget_painted_underlines();
     MappedWstring to_mapped_wstring(EditorViewType view, std::string_view str);
 
     bool aspell_reinit_settings();
@@ -89,9 +110,14 @@ public:
     bool hunspell_reinit_settings(bool reset_directory);
     void set_suggestions_box_transparency();
     void process_menu_result(WPARAM menu_id);
+    // Misspellings of the whole active document, taken from background check results when they're available and
+    // found in a single pass otherwise. Copying, exporting and counting of misspellings all go through it
+    std::vector<Misspelling> get_all_misspellings(EditorViewType view);
     void copy_misspellings_to_clipboard();
-    void update_delimiters();
+    void export_misspellings_to_file();
+    void update_char_classes();
     void on_settings_changed();
+    void on_dictionary_loaded();
     void init_suggestions_box();
     void hide_suggestion_box();
     void find_next_mistake();
@@ -102,14 +128,36 @@ public:
     std::vector<LanguageInfo> get_available_languages() const;
 
 private:
-    void create_word_underline(EditorViewType view, long start, long end);
-    void remove_underline(EditorViewType view, long start, long end);
+    void apply_underlines(EditorViewType view, long from, long to, const std::vector<std::pair<long, long>>& underlines);
     void clear_all_underlines(EditorViewType view);
-    bool check_word(EditorViewType view, std::wstring word, long start, long end);
+    bool check_word(std::wstring word);
+    bool is_style_skipped(EditorViewType view, long position);
+    bool is_skipped_style(EditorViewType view, int style);
+    // Parts of text (starting from skip_chars) consisting only of characters with checked styles
+    std::vector<std::wstring_view> get_checked_style_runs(EditorViewType view, const MappedWstring& text, long offset,
+                                                          size_t skip_chars);
     void get_visible_limits(EditorViewType view, long& start, long& finish);
     MappedWstring get_visible_text(EditorViewType view, long* offset, bool not_intersection_only = false);
     int check_text(EditorViewType view, const MappedWstring& text_to_check, long offset, CheckTextMode mode, size_t skip_chars = 0);
     void check_visible(EditorViewType view, bool not_intersection_only = false);
+    void start_document_check(EditorViewType view);
+    void cancel_document_check();
+    void start_suggestions_prefetch(EditorViewType view);
+    // Searches suggestions for the menu in background. Returned future gets fast suggestions as soon as the search
+    // reaches its slow part (or the complete ones with flag set if it hasn't any), complete suggestions of the same
+    // search replace fast ones shown in the menu when ready
+    std::future<std::pair<SuggestionList, bool>> start_complete_suggestions(std::wstring word);
+    size_t max_suggestion_count() const;
+    void update_suggestions_menu(const SuggestionList& suggestions);
+    // Speller lock for GUI thread, suggestion prefetch is stopped if it holds the lock (it's started again after
+    // visible text is checked)
+    std::unique_lock<std::mutex> lock_speller();
+    void on_suggestions_menu_closed();
+    // Suggestions might change for any word after dictionaries or ignored words changed
+    void clear_suggestion_cache();
+    bool find_mistake_in_document_check_results(bool forward);
+    std::pair<long, long> expand_to_lines(EditorViewType view, long from, long to);
+    DocumentMisspellings* current_document_misspellings(EditorViewType view);
     void set_encoding_by_id(int enc_id);
     std::vector<SuggestionsMenuItem> fill_suggestions_menu(HMENU menu);
     bool is_word_under_cursor_correct(long& pos, long& length,
@@ -117,23 +165,23 @@ private:
     std::wstring_view get_word_at(long char_pos, const MappedWstring& text, long offset) const;
     bool check_text_needed();
     void refresh_underline_style();
-    void apply_conversions(std::wstring& word);
-    void reset_hot_spot_cache();
-    void cut_apostrophes(std::wstring_view& word);
     std::optional<long> next_token_end(std::wstring_view target, long index) const;
     std::optional<long> prev_token_begin(std::wstring_view target, long index) const;
-    auto non_alphabetic_tokenizer (std::wstring_view target) const;
-    auto delimiter_tokenizer(std::wstring_view target) const;
 
 private:
     bool m_check_text_enabled; // cache for check_those
     bool m_word_under_cursor_is_correct;
     // converted to corresponding symbols
-    LRESULT m_hot_spot_cache[256]; // STYLE_MAX = 255
     const Settings &m_settings;
-    std::wstring m_delimiters;
+    // Tokenization settings current table was built for
+    std::tuple<TokenizationStyle, std::wstring, std::wstring, bool> m_char_classes_key;
+    std::shared_ptr<const CharClassTable> m_char_classes;
 
+    // Suggestions shown by the last suggestions menu, ids of its items are indices in it
     std::vector<std::wstring> m_last_suggestions;
+    // Dictionary which gave them, it's selected again before adding the word since other words might have been
+    // looked up in between
+    std::optional<size_t> m_last_suggestions_dictionary;
     long m_word_under_cursor_pos;
     long m_word_under_cursor_length;
     long m_current_position;
@@ -144,7 +192,30 @@ private:
     long m_visible_text_offset;
     long m_previous_a, m_previous_b;
     EditorInterface &m_editor;
-    std::wstring_view last_result; // workaround for getting latest misspelling
+    WordVerdictCache m_verdict_cache;
+    std::shared_ptr<SuggestionCache> m_suggestion_cache;
+    // Misspellings found by the last underlining pass, their suggestions are prefetched in background
+    std::vector<std::pair<long, std::wstring>> m_underlined_words;
+    // Ranges of text modified since the last check, positions are kept valid by shifting on each modification
+    enum_array<EditorViewType, std::vector<std::pair<long, long>>> m_modified_ranges;
+    // Visible range at the last check, shifted like modified ranges so text brought into view by edits is detected
+    enum_array<EditorViewType, std::pair<long, long>> m_checked_visible_ranges;
+    enum_array<EditorViewType, PaintedUnderlines> m_painted_underlines;
+
+    // Guards spellers from simultaneous usage by GUI thread and background check
+    std::shared_ptr<std::mutex> m_speller_mutex;
+    TaskWrapper m_document_check_task;
+    std::wstring m_document_check_path; // document which is being checked in background now
+    struct TextModification {
+        long position;
+        long length;
+        bool inserted;
+    };
+    std::vector<TextModification> m_document_check_modifications; // made to that document since check has started
+    std::unordered_map<std::wstring, DocumentMisspellings> m_document_misspellings; // by document path
+    TaskWrapper m_suggestions_prefetch_task;
+    TaskWrapper m_complete_suggestions_task;
+    HMENU m_open_suggestions_menu = nullptr;
 
     SpellerInterface* m_current_speller;
     std::unique_ptr<AspellInterface> m_aspell_speller;
@@ -19,6 +19,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #pragma once
 #include <MainDef.h>
 
+#include <chrono>
+#include <functional>
+
 class LanguageInfo;
 
 class SpellerInterface {
@@ -32,11 +35,26 @@ public:
   const std::vector<std::wstring>& list) = 0;         // Languages are from LangList
   void set_mode(int multi) { m_multi_mode = multi; } // Multi - 1, Single - 0
   virtual bool check_word(const wchar_t* word) = 0; // Word in Utf-8 or ANSI
-  // returned suggestions should be in utf-8
-  virtual std::vector<std::wstring> get_suggestions(const wchar_t* word) = 0;
+  // At most max_count (0: all) best suggestions
+  virtual std::vector<std::wstring> get_suggestions(const wchar_t* word, size_t max_count) = 0;
+  // Same with deadline, cancellation token and fast tier callback (may be empty). Search stops at deadline or
+  // cancellation returning suggestions found so far. If complete list needs a slow search, cheaper suggestions
+  // are passed to fast tier callback first
+  virtual std::vector<std::wstring> get_suggestions(const wchar_t* word, size_t max_count,
+                                                    std::chrono::steady_clock::time_point,
+                                                    const concurrency::cancellation_token&,
+                                                    const std::function<void(const std::vector<std::wstring>&)>&) {
+    return get_suggestions(word, max_count);
+  }
+  // Dictionary which gave the last suggestions (its index among set languages, none if there were no suggestions),
+  // words are added to it. Suggestions kept for later have to select it again
+  virtual std::optional<size_t> get_selected_dictionary() const = 0;
+  virtual void select_dictionary(std::optional<size_t> index) = 0;
   virtual void add_to_dictionary(const wchar_t* word) = 0;
   virtual void ignore_all(const wchar_t* word) = 0;
   virtual bool is_working() const = 0;
+  // Words are accepted while some of dictionaries are still loading, such verdicts are not final
+  virtual bool is_loading() const { return false; }
 
 protected:
   int m_multi_mode = 0;
@@ -0,0 +1,17 @@
+#include "SpellerOrder.h"
+
+void SpellerOrder::reset(size_t count) {
+    m_count = count;
+    uint64_t order = 0;
+    for (size_t pos = 0; pos < std::min(count, max_ordered); ++pos)
+        order |= static_cast<uint64_t>(pos) << (bits_per_index * pos);
+    m_order.store(order, std::memory_order_relaxed);
+}
+
+uint64_t SpellerOrder::moved_to_front(uint64_t order, size_t pos) {
+    auto shift = bits_per_index * pos;
+    auto before_mask = (uint64_t{1} << shift) - 1;
+    // Indices after pos stay where they are, ones before it move by one position
+    auto after = pos + 1 < max_ordered ? order & ~((uint64_t{1} << (shift + bits_per_index)) - 1) : 0;
+    return after | ((order & before_mask) << bits_per_index) | index_at(order, pos);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+
+// Order in which dictionaries are tried in multi-language mode. Dictionaries which accepted words most recently go
+// first since neighbouring words are usually in the same language. Order is packed into a single atomic so threads
+// checking words at the same time share it without locking, only first max_ordered dictionaries are reordered.
+class SpellerOrder {
+public:
+    void reset(size_t count);
+    size_t size() const { return m_count; }
+
+    // Calls accepts with dictionary indices in current order until it returns true and moves that dictionary to front
+    template <typename AcceptsType>
+    bool find_first(AcceptsType accepts) {
+        auto order = m_order.load(std::memory_order_relaxed);
+        for (size_t pos = 0; pos < m_count; ++pos) {
+            auto index = pos < max_ordered ? index_at(order, pos) : pos;
+            if (accepts(index)) {
+                if (pos > 0 && pos < max_ordered)
+                    m_order.store(moved_to_front(order, pos), std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static constexpr size_t max_ordered = 16;
+
+private:
+    static size_t index_at(uint64_t order, size_t pos) { return (order >> (bits_per_index * pos)) & index_mask; }
+    static uint64_t moved_to_front(uint64_t order, size_t pos);
+
+    static constexpr size_t bits_per_index = 4;
+    static constexpr uint64_t index_mask = (1 << bits_per_index) - 1;
+
+    std::atomic<uint64_t> m_order{0};
+    size_t m_count = 0;
+};
@@ -0,0 +1,32 @@
+#include "SuggestionCache.h"
+
+SuggestionCache::SuggestionCache(size_t capacity) : m_capacity(capacity) {
+}
+
+const SuggestionList* SuggestionCache::find(const std::wstring& word) const {
+    auto it = m_suggestions.find(word);
+    if (it == m_suggestions.end())
+        return nullptr;
+    return &it->second;
+}
+
+void SuggestionCache::store(std::wstring word, SuggestionList suggestions) {
+    // Only misspellings user looked at or scrolled past are stored, so simply starting over is good enough
+    if (m_suggestions.size() >= m_capacity)
+        m_suggestions.clear();
+    m_suggestions.emplace(std::move(word), std::move(suggestions));
+}
+
+void SuggestionCache::clear() {
+    m_suggestions.clear();
+}
+
+void SuggestionCache::set_context(const SpellerInterface* speller, std::wstring language_set, size_t max_count) {
+    if (speller == m_speller && language_set == m_language_set && max_count == m_max_count)
+        return;
+
+    m_speller = speller;
+    m_language_set = std::move(language_set);
+    m_max_count = max_count;
+    clear();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <unordered_map>
+
+class SpellerInterface;
+
+// Suggestions with the dictionary which gave them, see SpellerInterface::get_selected_dictionary
+struct SuggestionList {
+    std::vector<std::wstring> suggestions;
+    std::optional<size_t> dictionary;
+};
+
+// Bounded cache of speller suggestions for misspelled words already passed through conversions.
+// It's filled speculatively by background prefetch as well as by suggestion menus, so it's not synchronized by itself
+// and is used only under speller lock. Like verdicts, suggestions are valid only for speller and language set they
+// were obtained with, and also for the number of suggestions requested since lists are cut to it.
+class SuggestionCache {
+public:
+    explicit SuggestionCache(size_t capacity = default_capacity);
+    const SuggestionList* find(const std::wstring& word) const;
+    void store(std::wstring word, SuggestionList suggestions);
+    void clear();
+    void set_context(const SpellerInterface* speller, std::wstring language_set, size_t max_count);
+
+    static constexpr size_t default_capacity = 1024;
+
+private:
+    std::unordered_map<std::wstring, SuggestionList> m_suggestions;
+    size_t m_capacity;
+    const SpellerInterface* m_speller = nullptr;
+    std::wstring m_language_set;
+    size_t m_max_count = 0;
+};
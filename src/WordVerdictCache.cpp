@@ -0,0 +1,48 @@
+#include "WordVerdictCache.h"
+
+WordVerdictCache::WordVerdictCache(size_t capacity) : m_capacity(capacity) {
+}
+
+std::optional<bool> WordVerdictCache::find(const std::wstring& word) const {
+    auto it = m_verdicts.find(word);
+    if (it == m_verdicts.end())
+        return std::nullopt;
+    return it->second;
+}
+
+void WordVerdictCache::store(std::wstring word, bool verdict) {
+    // Visible area rarely has more than a few thousand distinct words so simply starting over is good enough
+    if (m_verdicts.size() >= m_capacity)
+        m_verdicts.clear();
+    m_verdicts.emplace(std::move(word), verdict);
+}
+
+void WordVerdictCache::invalidate(std::wstring_view word) {
+    auto equal_ignoring_case = [word](const std::wstring& other)
+    {
+        return other.length() == word.length() && std::equal(other.begin(), other.end(), word.begin(),
+                                                             [](wchar_t a, wchar_t b)
+                                                             {
+                                                                 return towlower(a) == towlower(b);
+                                                             });
+    };
+    for (auto it = m_verdicts.begin(); it != m_verdicts.end();) {
+        if (equal_ignoring_case(it->first))
+            it = m_verdicts.erase(it);
+        else
+            ++it;
+    }
+}
+
+void WordVerdictCache::clear() {
+    m_verdicts.clear();
+}
+
+void WordVerdictCache::set_context(const SpellerInterface* speller, std::wstring language_set) {
+    if (speller == m_speller && language_set == m_language_set)
+        return;
+
+    m_speller = speller;
+    m_language_set = std::move(language_set);
+    clear();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <unordered_map>
+
+class SpellerInterface;
+
+// Bounded cache of speller verdicts for words already passed through conversions.
+// Verdicts are valid only for speller and language set they were obtained with,
+// so the whole cache is dropped when any of those changes.
+class WordVerdictCache {
+public:
+    explicit WordVerdictCache(size_t capacity = default_capacity);
+    std::optional<bool> find(const std::wstring& word) const;
+    void store(std::wstring word, bool verdict);
+    // Removes word and its case variants since spellers accept capitalized forms of known words
+    void invalidate(std::wstring_view word);
+    void clear();
+    void set_context(const SpellerInterface* speller, std::wstring language_set);
+
+    static constexpr size_t default_capacity = 32768;
+
+private:
+    std::unordered_map<std::wstring, bool> m_verdicts;
+    size_t m_capacity;
+    const SpellerInterface* m_speller = nullptr;
+    std::wstring m_language_set;
+};
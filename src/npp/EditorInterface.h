@@ -20,6 +20,14 @@ enum class EditorCodepage
     COUNT,
 };
 
+// Range [from, to) which should be either filled with indicator or cleared
+struct IndicatorRange
+{
+    long from;
+    long to;
+    bool fill;
+};
+
 class EditorRect
 {
 public:
@@ -59,9 +67,7 @@ public:
     virtual void replace_selection(EditorViewType view, const char *str) = 0;
     virtual void set_indicator_style (EditorViewType view, int indicator_index, int style) = 0;
     virtual void set_indicator_foreground (EditorViewType view, int indicator_index, int style) = 0;
-    virtual void set_current_indicator (EditorViewType view, int indicator_index) = 0;
-    virtual void indicator_fill_range (EditorViewType view, long from, long to) = 0;
-    virtual void indicator_clear_range (EditorViewType view, long from, long to) = 0;
+    virtual void apply_indicator_ranges (EditorViewType view, int indicator_index, const std::vector<IndicatorRange>& ranges) = 0;
 
     // const
     virtual std::vector<std::wstring> get_open_filenames(std::optional<EditorViewType> view = {}) const = 0;
@@ -86,11 +92,19 @@ public:
     virtual long get_selection_end (EditorViewType view) const = 0;
     virtual HWND app_handle() const = 0 ;
     virtual int get_style_at (EditorViewType view, long position) const = 0;
+    // styles of all characters in range [from, to) fetched at once
+    virtual std::vector<unsigned char> get_styles (EditorViewType view, long from, long to) const = 0;
     virtual std::wstring get_full_current_path () const = 0;
+    // path of the document shown in the view, empty if the view is hidden
+    virtual std::wstring get_full_current_path (EditorViewType view) const = 0;
     // is current style used for links (hotspots):
     virtual bool is_style_hotspot (EditorViewType view, int style) const = 0;
     virtual long get_active_document_length (EditorViewType view) const = 0;
     virtual std::string get_text_range (EditorViewType view, long from, long to) const = 0;
+    // Views below point directly into editor buffer, so they should be consumed right away: they become invalid
+    // after any document modification and after any other request for a view
+    virtual std::string_view get_text_range_view (EditorViewType view, long from, long to) const = 0;
+    virtual std::string_view get_active_document_text_view (EditorViewType view) const = 0;
     virtual long get_line_length(EditorViewType view, int line) const = 0;
     virtual int get_point_x_from_position (EditorViewType view, long position) const = 0;
     virtual int get_point_y_from_position (EditorViewType view, long position) const = 0;
@@ -6,6 +6,11 @@
 #include "menuCmdID.h"
 #include "MainDef.h"
 
+// Available since Scintilla 3.3 but missing from bundled Scintilla.h
+#ifndef SCI_GETRANGEPOINTER
+#define SCI_GETRANGEPOINTER 2643
+#endif
+
 NppInterface::NppInterface(const NppData* nppData) : m_npp_data{*nppData}
 {
 }
@@ -61,6 +66,15 @@ HWND NppInterface::get_scintilla_hwnd(EditorViewType view) const
     return handle;
 }
 
+std::optional<EditorViewType> NppInterface::view_from_scintilla_hwnd(HWND hwnd) const
+{
+    if (hwnd == m_npp_data.scintilla_main_handle)
+        return EditorViewType::primary;
+    if (hwnd == m_npp_data.scintilla_second_handle)
+        return EditorViewType::secondary;
+    return std::nullopt;
+}
+
 LRESULT NppInterface::send_msg_to_scintilla(EditorViewType view, UINT msg, WPARAM w_param, LPARAM l_param) const
 {
     return SendMessage(get_scintilla_hwnd(view), msg, w_param, l_param);
@@ -193,19 +207,16 @@ void NppInterface::set_indicator_foreground(EditorViewType view, int indicator_i
     send_msg_to_scintilla(view, SCI_INDICSETFORE, indicator_index, style);
 }
 
-void NppInterface::set_current_indicator(EditorViewType view, int indicator_index)
+void NppInterface::apply_indicator_ranges(EditorViewType view, int indicator_index,
+                                          const std::vector<IndicatorRange>& ranges)
 {
-    post_msg_to_scintilla(view, SCI_SETINDICATORCURRENT, indicator_index);
-}
-
-void NppInterface::indicator_fill_range(EditorViewType view, long from, long to)
-{
-    post_msg_to_scintilla(view, SCI_INDICATORFILLRANGE, from, to - from + 1);
-}
+    if (ranges.empty())
+        return;
 
-void NppInterface::indicator_clear_range(EditorViewType view, long from, long to)
-{
-    post_msg_to_scintilla(view, SCI_INDICATORCLEARRANGE, from, to - from + 1);
+    post_msg_to_scintilla(view, SCI_SETINDICATORCURRENT, indicator_index);
+    for (auto& range : ranges)
+        post_msg_to_scintilla(view, range.fill ? SCI_INDICATORFILLRANGE : SCI_INDICATORCLEARRANGE, range.from,
+                              range.to - range.from);
 }
 
 long NppInterface::get_first_visible_line(EditorViewType view) const
@@ -243,6 +254,18 @@ std::wstring NppInterface::get_full_current_path() const
     return full_path.data ();
 }
 
+std::wstring NppInterface::get_full_current_path(EditorViewType view) const
+{
+    auto npp_view = view == EditorViewType::primary ? MAIN_VIEW : SUB_VIEW;
+    auto index = static_cast<int>(send_msg_to_npp(NPPM_GETCURRENTDOCINDEX, 0, npp_view));
+    if (index < 0)
+        return {};
+    auto buffer_id = send_msg_to_npp(NPPM_GETBUFFERIDFROMPOS, index, npp_view);
+    std::vector<wchar_t> full_path(MAX_PATH);
+    send_msg_to_npp(NPPM_GETFULLPATHFROMBUFFERID, buffer_id, reinterpret_cast<LPARAM>(full_path.data ()));
+    return full_path.data ();
+}
+
 std::optional<long> NppInterface::char_position_from_point(EditorViewType view, int x, int y) const
 {
     POINT p;
@@ -349,16 +372,9 @@ void NppInterface::notify(SCNotification* notify_code)
     switch (notify_code->nmhdr.code)
     {
     case NPPN_LANGCHANGED:
-        {
-            for (auto& val : m_lexer_cache)
-                val = std::nullopt;
-        }
-        break;
     case NPPN_BUFFERACTIVATED:
-        {
-            for (auto& val : m_lexer_cache)
-                val = std::nullopt;
-        }
+    case NPPN_WORDSTYLESUPDATED:
+        reset_style_caches();
         break;
     }
 }
@@ -372,13 +388,43 @@ int NppInterface::get_lexer(EditorViewType view) const
 
 int NppInterface::get_style_at(EditorViewType view, long position) const
 {
-    return static_cast<int>(send_msg_to_scintilla(view, SCI_GETSTYLEAT, position));
+    // Style bytes might come sign-extended from older Scintilla versions
+    return static_cast<unsigned char>(send_msg_to_scintilla(view, SCI_GETSTYLEAT, position));
+}
+
+std::vector<unsigned char> NppInterface::get_styles(EditorViewType view, long from, long to) const
+{
+    if (to <= from)
+        return {};
+    Sci_TextRange range;
+    range.chrg.cpMin = from;
+    range.chrg.cpMax = to;
+    // SCI_GETSTYLEDTEXT interleaves characters with their styles and terminates result with two zero bytes
+    std::vector<char> buf(2 * (to - from) + 2);
+    range.lpstrText = buf.data ();
+    send_msg_to_scintilla(view, SCI_GETSTYLEDTEXT, 0, reinterpret_cast<LPARAM>(&range));
+    std::vector<unsigned char> styles(to - from);
+    for (long i = 0; i < to - from; ++i)
+        styles[i] = static_cast<unsigned char>(buf[2 * i + 1]);
+    return styles;
 }
 
 bool NppInterface::is_style_hotspot(EditorViewType view, int style) const
 {
-    // TODO: implement cache
-    return send_msg_to_scintilla(view, SCI_STYLEGETHOTSPOT, style) != 0;
+    auto& cache = m_hotspot_cache[view];
+    if (!cache.known_styles[style]) {
+        cache.hotspot_styles[style] = send_msg_to_scintilla(view, SCI_STYLEGETHOTSPOT, style) != 0;
+        cache.known_styles[style] = true;
+    }
+    return cache.hotspot_styles[style];
+}
+
+void NppInterface::reset_style_caches()
+{
+    for (auto& val : m_lexer_cache)
+        val = std::nullopt;
+    for (auto& val : m_hotspot_cache)
+        val = {};
 }
 
 long NppInterface::get_active_document_length(EditorViewType view) const
@@ -388,13 +434,28 @@ long NppInterface::get_active_document_length(EditorViewType view) const
 
 std::string NppInterface::get_text_range(EditorViewType view, long from, long to) const
 {
-    Sci_TextRange range;
-    range.chrg.cpMin = from;
-    range.chrg.cpMax = to;
-    std::vector<char> buf(range.chrg.cpMax - range.chrg.cpMin + 1);
-    range.lpstrText = buf.data ();
-    send_msg_to_scintilla(view, SCI_GETTEXTRANGE, 0, reinterpret_cast<LPARAM>(&range));
-    return buf.data();
+    return std::string(get_text_range_view(view, from, to));
+}
+
+std::string_view NppInterface::get_text_range_view(EditorViewType view, long from, long to) const
+{
+    from = std::max(from, 0L);
+    to = std::min(to, get_active_document_length(view));
+    if (to <= from)
+        return {};
+    // Gap buffer is moved out of the range if needed, so range becomes contiguous
+    auto ptr = reinterpret_cast<const char *>(send_msg_to_scintilla(view, SCI_GETRANGEPOINTER, from, to - from));
+    if (!ptr)
+        return {};
+    return {ptr, static_cast<size_t>(to - from)};
+}
+
+std::string_view NppInterface::get_active_document_text_view(EditorViewType view) const
+{
+    auto ptr = reinterpret_cast<const char *>(send_msg_to_scintilla(view, SCI_GETCHARACTERPOINTER));
+    if (!ptr)
+        return {};
+    return {ptr, static_cast<size_t>(get_active_document_length(view))};
 }
 
 void NppInterface::force_style_update(EditorViewType view, long from, long to)
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "utils/enum_array.h"
+#include "SciUtils.h"
 
 struct SCNotification;
 struct NppData;
@@ -46,9 +47,12 @@ public:
     void notify(SCNotification* notify_code);
     int get_lexer(EditorViewType view) const override;
     int get_style_at(EditorViewType view, long position) const override;
+    std::vector<unsigned char> get_styles(EditorViewType view, long from, long to) const override;
     bool is_style_hotspot(EditorViewType view, int style) const override;
     long get_active_document_length(EditorViewType view) const override;
     std::string get_text_range(EditorViewType view, long from, long to) const override;
+    std::string_view get_text_range_view(EditorViewType view, long from, long to) const override;
+    std::string_view get_active_document_text_view(EditorViewType view) const override;
     void force_style_update(EditorViewType view, long from, long to) override;
     std::optional<long> char_position_from_point(EditorViewType view, int x, int y) const override;
     long get_selection_start(EditorViewType view) const override;
@@ -60,6 +64,7 @@ public:
 
 public:
     HWND get_scintilla_hwnd(EditorViewType view) const;
+    std::optional<EditorViewType> view_from_scintilla_hwnd(HWND hwnd) const;
 
 private:
     // these functions are const per se
@@ -77,16 +82,24 @@ public:
     void replace_selection(EditorViewType view, const char* str) override;
     void set_indicator_style(EditorViewType view, int indicator_index, int style) override;
     void set_indicator_foreground(EditorViewType view, int indicator_index, int style) override;
-    void set_current_indicator(EditorViewType view, int indicator_index) override;
-    void indicator_fill_range(EditorViewType view, long from, long to) override;
-    void indicator_clear_range(EditorViewType view, long from, long to) override;
+    void apply_indicator_ranges(EditorViewType view, int indicator_index, const std::vector<IndicatorRange>& ranges) override;
     long get_first_visible_line(EditorViewType view) const override;
     long get_lines_on_screen(EditorViewType view) const override;
     long get_document_line_from_visible(EditorViewType view, long visible_line) const override;
     long get_document_line_count(EditorViewType view) const override;
     std::vector<char> get_active_document_text(EditorViewType view) const override;
     std::wstring get_full_current_path() const override;
+    std::wstring get_full_current_path(EditorViewType view) const override;
+private:
+    void reset_style_caches();
+
 private:
     const NppData& m_npp_data;
     mutable enum_array<EditorViewType, std::optional<int>> m_lexer_cache;
+    // hotspot flag of a style is valid only if its bit in known_styles is set
+    struct HotspotCache {
+        SciUtils::StyleMask known_styles;
+        SciUtils::StyleMask hotspot_styles;
+    };
+    mutable enum_array<EditorViewType, HotspotCache> m_hotspot_cache;
 };
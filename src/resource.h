@@ -88,3 +88,4 @@
 #define IDC_DELIMITERS                          40001
 #define IDC_DELIMITER_EXCLUSIONS_LE             40002
 #define IDC_CAMEL_CASE_SPLITTING_CB             40003
+#define IDC_BACKGROUND_CHECK_CB                 40004
@@ -0,0 +1,57 @@
+#include "OffsetMapping.h"
+
+#include <algorithm>
+
+void OffsetMapping::append(long offset) {
+    append_run(offset, 1, 0);
+}
+
+void OffsetMapping::append_run(long offset, long count, long step) {
+    if (count <= 0)
+        return;
+
+    if (!m_segments.empty()) {
+        auto& last = m_segments.back();
+        auto last_length = m_size - last.index;
+        // Step of single element segment or run is not fixed yet so it's taken from the neighbour
+        if (last_length == 1 && offset >= last.offset && (count == 1 || offset - last.offset == step)) {
+            last.step = offset - last.offset;
+            m_size += count;
+            return;
+        }
+        if (last_length > 1 && offset == last.offset + last_length * last.step && (count == 1 || step == last.step)) {
+            m_size += count;
+            return;
+        }
+    }
+    m_segments.push_back({m_size, offset, count == 1 ? 0 : step});
+    m_size += count;
+}
+
+void OffsetMapping::shift(long delta) {
+    for (auto& segment : m_segments)
+        segment.offset += delta;
+}
+
+long OffsetMapping::to_original(long index) const {
+    auto it = std::upper_bound(m_segments.begin(), m_segments.end(), index,
+                               [](long value, const Segment& segment) { return value < segment.index; });
+    if (it == m_segments.begin())
+        return index;
+    --it;
+    return it->offset + (index - it->index) * it->step;
+}
+
+long OffsetMapping::from_original(long offset) const {
+    // Last segment starting before offset might still contain it, otherwise answer is the start of the next one
+    auto next = std::lower_bound(m_segments.begin(), m_segments.end(), offset,
+                                 [](const Segment& segment, long value) { return segment.offset < value; });
+    auto next_index = next != m_segments.end() ? next->index : m_size;
+    if (next == m_segments.begin())
+        return next_index;
+    auto& segment = *std::prev(next);
+    if (segment.step == 0)
+        return next_index;
+    auto steps = (offset - segment.offset + segment.step - 1) / segment.step;
+    return std::min(segment.index + steps, next_index);
+}
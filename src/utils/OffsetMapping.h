@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+// Non-decreasing mapping from index to offset in some original encoding.
+// Stored as segments in which offset grows by a constant step per index, so long runs of
+// characters with equal encoded length (ASCII in UTF-8 for instance) take constant space.
+class OffsetMapping {
+public:
+    void append(long offset);
+    // appends count indices with offsets offset, offset + step, ...
+    void append_run(long offset, long count, long step);
+    void shift(long delta);
+    bool empty() const { return m_size == 0; }
+    long size() const { return m_size; }
+    long to_original(long index) const;
+    // first index with offset not less than given (same as lower_bound over all offsets)
+    long from_original(long offset) const;
+
+private:
+    struct Segment {
+        long index;
+        long offset;
+        long step;
+    };
+    std::vector<Segment> m_segments;
+    long m_size = 0;
+};
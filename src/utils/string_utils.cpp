@@ -1 +1,62 @@
 #include "string_utils.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STRING_UTILS_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef STRING_UTILS_USE_SSE2
+// All 16-bit lanes of chars in [from, to], valid only for ranges within positive signed values
+static __m128i in_range(__m128i chars, short from, short to) {
+    return _mm_and_si128(_mm_cmpgt_epi16(chars, _mm_set1_epi16(static_cast<short>(from - 1))),
+                         _mm_cmplt_epi16(chars, _mm_set1_epi16(static_cast<short>(to + 1))));
+}
+#endif
+
+#if defined(__AVX2__)
+static __m256i in_range(__m256i chars, short from, short to) {
+    return _mm256_and_si256(_mm256_cmpgt_epi16(chars, _mm256_set1_epi16(static_cast<short>(from - 1))),
+                            _mm256_cmpgt_epi16(_mm256_set1_epi16(static_cast<short>(to + 1)), chars));
+}
+#endif
+
+size_t CharClassTable::plain_word_prefix_length(std::wstring_view str) const {
+    if (!m_ascii_alnum_are_word_chars)
+        return 0;
+
+    // Upper case letters might start new word when camel case is split
+    bool allow_upper = !m_split_camel_case;
+    size_t i = 0;
+    if constexpr (sizeof(wchar_t) == 2) {
+        auto data = reinterpret_cast<const char *>(str.data());
+#if defined(__AVX2__)
+        for (; i + 16 <= str.length(); i += 16) {
+            auto chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i * sizeof(wchar_t)));
+            auto matches = _mm256_or_si256(in_range(chars, 'a', 'z'), in_range(chars, '0', '9'));
+            if (allow_upper)
+                matches = _mm256_or_si256(matches, in_range(chars, 'A', 'Z'));
+            if (static_cast<unsigned>(_mm256_movemask_epi8(matches)) != 0xFFFFFFFFu)
+                break;
+        }
+#endif
+#ifdef STRING_UTILS_USE_SSE2
+        for (; i + 8 <= str.length(); i += 8) {
+            auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * sizeof(wchar_t)));
+            auto matches = _mm_or_si128(in_range(chars, 'a', 'z'), in_range(chars, '0', '9'));
+            if (allow_upper)
+                matches = _mm_or_si128(matches, in_range(chars, 'A', 'Z'));
+            if (_mm_movemask_epi8(matches) != 0xFFFF)
+                break;
+        }
+#endif
+    }
+    for (; i < str.length(); ++i) {
+        auto c = str[i];
+        if (!((c >= L'a' && c <= L'z') || (c >= L'0' && c <= L'9') || (allow_upper && c >= L'A' && c <= L'Z')))
+            break;
+    }
+    return i;
+}
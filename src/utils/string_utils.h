@@ -1,5 +1,7 @@
 #pragma once
 
+#include "unicode.h"
+
 template <typename IsDelimiterType>
 class Tokenizer {
 public:
@@ -25,7 +27,7 @@ public:
             if (!m_is_delimiter(m_target[i])) {
                 if (m_split_camel_case && i
                     >
-                    token_begin && IsCharUpper(m_target [i]) && IsCharLower(m_target [i - 1])
+                    token_begin && unicode_is_upper(m_target [i]) && unicode_is_lower(m_target [i - 1])
                 ) {
                     token_end = i;
                     finalize_word();
@@ -49,8 +51,8 @@ public:
         while (index >= 0 && !m_is_delimiter(m_target[index])) {
             if (m_split_camel_case
                 && index > 0
-                && IsCharLower(m_target[index - 1])
-                && IsCharUpper(m_target[index]))
+                && unicode_is_lower(m_target[index - 1])
+                && unicode_is_upper(m_target[index]))
                 return index;
             --index;
         }
@@ -64,8 +66,8 @@ public:
         while (index < static_cast<long> (m_target.length()) && !m_is_delimiter(m_target[index])) {
             if (m_split_camel_case
                 && index < static_cast<long> (m_target.length()) - 1
-                && IsCharUpper(m_target[index + 1])
-                && IsCharLower(m_target[index]))
+                && unicode_is_upper(m_target[index + 1])
+                && unicode_is_lower(m_target[index]))
                 return index;
             ++index;
         }
@@ -89,3 +91,158 @@ inline auto make_delimiter_tokenizer(std::wstring_view target, std::wstring_view
     return make_condition_tokenizer(target, [=](wchar_t c) { return delimiters.find(c) != std::string_view::npos; },
                                     split_camel_case);
 }
+
+// Classes of all BMP characters used by tokenization, computed once per change of tokenization settings
+class CharClassTable {
+public:
+    enum : unsigned char {
+        delimiter = 1 << 0,
+        upper = 1 << 1,
+        lower = 1 << 2,
+    };
+
+    template <typename IsDelimiterType>
+    CharClassTable(const IsDelimiterType& is_delimiter, bool split_camel_case)
+        : m_classes(0x10000),
+          m_split_camel_case(split_camel_case) {
+        for (size_t i = 0; i < m_classes.size(); ++i) {
+            auto c = static_cast<wchar_t>(i);
+            m_classes[i] = static_cast<unsigned char>((is_delimiter(c) ? delimiter : 0) |
+                (unicode_is_upper(c) ? upper : 0) | (unicode_is_lower(c) ? lower : 0));
+        }
+        m_ascii_alnum_are_word_chars = true;
+        for (auto range : {std::pair{L'0', L'9'}, std::pair{L'A', L'Z'}, std::pair{L'a', L'z'}})
+            for (auto c = range.first; c <= range.second; ++c)
+                if (is_delimiter(c))
+                    m_ascii_alnum_are_word_chars = false;
+    }
+
+    bool is_delimiter(wchar_t c) const { return (get(c) & delimiter) != 0; }
+    // Camel case words are split between lower case character and following upper case one
+    bool is_camel_case_boundary(wchar_t prev, wchar_t c) const {
+        return m_split_camel_case && (get(prev) & lower) != 0 && (get(c) & upper) != 0;
+    }
+    // Length of prefix consisting of ASCII letters and digits which can't split the word they continue
+    size_t plain_word_prefix_length(std::wstring_view str) const;
+
+private:
+    unsigned char get(wchar_t c) const {
+        return static_cast<size_t>(c) < m_classes.size() ? m_classes[static_cast<size_t>(c)] : 0;
+    }
+
+private:
+    std::vector<unsigned char> m_classes;
+    bool m_split_camel_case;
+    bool m_ascii_alnum_are_word_chars;
+};
+
+// Same tokenization as Tokenizer but tokens are found lazily while iterating
+class TableTokenizer {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::wstring_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::wstring_view*;
+        using reference = const std::wstring_view&;
+
+        // end iterator
+        Iterator() = default;
+        Iterator(std::wstring_view target, const CharClassTable& table) : m_target(target), m_table(&table) {
+            advance();
+        }
+
+        reference operator*() const { return m_token; }
+        pointer operator->() const { return &m_token; }
+        Iterator& operator++() {
+            advance();
+            return *this;
+        }
+        Iterator operator++(int) {
+            auto copy = *this;
+            advance();
+            return copy;
+        }
+        bool operator==(const Iterator& other) const {
+            return m_table == other.m_table && (!m_table || m_pos == other.m_pos);
+        }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    private:
+        bool finalize_token() {
+            if (m_token_begin >= m_token_end)
+                return false;
+            m_token = m_target.substr(m_token_begin, m_token_end - m_token_begin);
+            m_token_end = -1;
+            return true;
+        }
+
+        void advance() {
+            auto length = static_cast<std::ptrdiff_t>(m_target.length());
+            while (m_pos < length) {
+                auto i = m_pos++;
+                if (m_table->is_delimiter(m_target[i])) {
+                    bool finalized = finalize_token();
+                    m_token_begin = i + 1;
+                    if (finalized)
+                        return;
+                }
+                else if (i > m_token_begin && m_table->is_camel_case_boundary(m_target[i - 1], m_target[i])) {
+                    m_token_end = i;
+                    finalize_token();
+                    m_token_begin = i;
+                    return;
+                }
+                else {
+                    m_pos += static_cast<std::ptrdiff_t>(m_table->plain_word_prefix_length(m_target.substr(m_pos)));
+                    m_token_end = m_pos;
+                }
+            }
+            if (!finalize_token())
+                m_table = nullptr;
+        }
+
+    private:
+        std::wstring_view m_target;
+        const CharClassTable* m_table = nullptr;
+        std::wstring_view m_token;
+        std::ptrdiff_t m_pos = 0;
+        std::ptrdiff_t m_token_begin = 0;
+        std::ptrdiff_t m_token_end = -1;
+    };
+
+    TableTokenizer(std::wstring_view target, const CharClassTable& table) : m_target(target), m_table(table) {
+    }
+
+    Iterator begin() const { return {m_target, m_table}; }
+    Iterator end() const { return {}; }
+
+    std::optional<long> prev_token_begin(long index) const {
+        if (m_table.is_delimiter(m_target[index]))
+            return std::nullopt;
+        while (index >= 0 && !m_table.is_delimiter(m_target[index])) {
+            if (index > 0 && m_table.is_camel_case_boundary(m_target[index - 1], m_target[index]))
+                return index;
+            --index;
+        }
+        ++index;
+        return index;
+    }
+
+    std::optional<long> next_token_end(long index) const {
+        if (m_table.is_delimiter(m_target[index]))
+            return std::nullopt;
+        while (index < static_cast<long> (m_target.length()) && !m_table.is_delimiter(m_target[index])) {
+            if (index < static_cast<long> (m_target.length()) - 1
+                && m_table.is_camel_case_boundary(m_target[index], m_target[index + 1]))
+                return index;
+            ++index;
+        }
+        return index;
+    }
+
+private:
+    std::wstring_view m_target;
+    const CharClassTable& m_table;
+};
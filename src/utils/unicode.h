@@ -0,0 +1,23 @@
+#pragma once
+
+// Character properties for BMP looked up in two-stage tables generated by generate_unicode_tables.py,
+// characters outside of BMP have none of them
+enum : unsigned char {
+    unicode_alnum = 1 << 0,
+    unicode_upper = 1 << 1,
+    unicode_lower = 1 << 2,
+};
+
+extern const unsigned char unicode_block_index[256];
+extern const unsigned char unicode_blocks[][256];
+
+inline unsigned char unicode_char_flags(wchar_t c) {
+    auto code = static_cast<unsigned>(c);
+    if (code > 0xFFFF)
+        return 0;
+    return unicode_blocks[unicode_block_index[code >> 8]][code & 0xFF];
+}
+
+inline bool unicode_is_alnum(wchar_t c) { return (unicode_char_flags(c) & unicode_alnum) != 0; }
+inline bool unicode_is_upper(wchar_t c) { return (unicode_char_flags(c) & unicode_upper) != 0; }
+inline bool unicode_is_lower(wchar_t c) { return (unicode_char_flags(c) & unicode_lower) != 0; }
@@ -1,5 +1,16 @@
 #include "utf8.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF8_USE_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 bool utf8_is_lead(char c)
 {
     return (((c & 0x80) == 0) // 0xxxxxxx
@@ -95,3 +106,214 @@ size_t utf8_length(const char* string)
     }
     return size;
 }
+
+#if defined(__AVX2__) || defined(UTF8_USE_SSE2)
+static unsigned lowest_set_bit(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+static size_t ascii_prefix_length(const unsigned char* begin, const unsigned char* end)
+{
+    auto it = begin;
+#if defined(__AVX2__)
+    for (; end - it >= 32; it += 32)
+    {
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(it))));
+        if (mask != 0)
+            return static_cast<size_t>(it - begin) + lowest_set_bit(mask);
+    }
+#endif
+#ifdef UTF8_USE_SSE2
+    for (; end - it >= 16; it += 16)
+    {
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(it))));
+        if (mask != 0)
+            return static_cast<size_t>(it - begin) + lowest_set_bit(mask);
+    }
+#endif
+    while (it != end && *it < 0x80)
+        ++it;
+    return static_cast<size_t>(it - begin);
+}
+
+static void widen_ascii(const unsigned char* src, size_t len, wchar_t* dst)
+{
+    size_t i = 0;
+    if constexpr (sizeof(wchar_t) == 2)
+    {
+#if defined(__AVX2__)
+        for (; i + 16 <= len; i += 16)
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                                _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i))));
+#endif
+#ifdef UTF8_USE_SSE2
+        auto zero = _mm_setzero_si128();
+        for (; i + 16 <= len; i += 16)
+        {
+            auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_unpacklo_epi8(bytes, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 8), _mm_unpackhi_epi8(bytes, zero));
+        }
+#endif
+    }
+    for (; i < len; ++i)
+        dst[i] = src[i];
+}
+
+static constexpr char32_t replacement_character = 0xFFFD;
+
+// Decodes single non-ASCII character, on failure only lead byte is consumed
+static char32_t decode_code_point(const unsigned char*& it, const unsigned char* end)
+{
+    auto lead = *it;
+    int cont_count;
+    char32_t code_point, min_code_point;
+    if ((lead & 0xE0) == 0xC0)
+    {
+        cont_count = 1;
+        code_point = lead & 0x1F;
+        min_code_point = 0x80;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+        cont_count = 2;
+        code_point = lead & 0x0F;
+        min_code_point = 0x800;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+        cont_count = 3;
+        code_point = lead & 0x07;
+        min_code_point = 0x10000;
+    }
+    else
+    {
+        ++it;
+        return replacement_character;
+    }
+
+    auto next = it + 1;
+    for (int i = 0; i < cont_count; ++i, ++next)
+    {
+        if (next == end || (*next & 0xC0) != 0x80)
+        {
+            ++it;
+            return replacement_character;
+        }
+        code_point = (code_point << 6) | (*next & 0x3F);
+    }
+    // overlong forms, surrogates and values past U+10FFFF are not valid UTF-8
+    if (code_point < min_code_point || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF))
+    {
+        ++it;
+        return replacement_character;
+    }
+    it = next;
+    return code_point;
+}
+
+// offsets are optional since plain conversions don't need them
+static void decode(std::string_view str, std::wstring& units, OffsetMapping* offsets)
+{
+    auto begin = reinterpret_cast<const unsigned char *>(str.data());
+    auto end = begin + str.length();
+    // Every character takes at least as many bytes as UTF-16 units
+    units.resize(str.length());
+    size_t unit = 0;
+    auto it = begin;
+    while (it != end)
+    {
+        auto ascii_len = ascii_prefix_length(it, end);
+        widen_ascii(it, ascii_len, units.data() + unit);
+        if (offsets)
+            offsets->append_run(static_cast<long>(it - begin), static_cast<long>(ascii_len), 1);
+        unit += ascii_len;
+        it += ascii_len;
+        if (it == end)
+            break;
+
+        auto char_start = static_cast<long>(it - begin);
+        auto code_point = decode_code_point(it, end);
+        if (code_point >= 0x10000)
+        {
+            code_point -= 0x10000;
+            units[unit++] = static_cast<wchar_t>(0xD800 + (code_point >> 10));
+            units[unit++] = static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF));
+            if (offsets)
+                offsets->append_run(char_start, 2, 0);
+        }
+        else
+        {
+            units[unit++] = static_cast<wchar_t>(code_point);
+            if (offsets)
+                offsets->append(char_start);
+        }
+    }
+    units.resize(unit);
+}
+
+void utf8_decode(std::string_view str, std::wstring& units, OffsetMapping& offsets)
+{
+    offsets = {};
+    decode(str, units, &offsets);
+    offsets.append(static_cast<long>(str.length()));
+}
+
+std::wstring utf8_to_utf16(std::string_view str)
+{
+    std::wstring result;
+    decode(str, result, nullptr);
+    return result;
+}
+
+std::string utf16_to_utf8(std::wstring_view str)
+{
+    std::string result;
+    result.reserve(str.length());
+    for (size_t i = 0; i < str.length(); ++i)
+    {
+        char32_t code_point = static_cast<char16_t>(str[i]);
+        if (code_point < 0x80)
+        {
+            result.push_back(static_cast<char>(code_point));
+            continue;
+        }
+        if (code_point >= 0xD800 && code_point <= 0xDFFF)
+        {
+            auto low = i + 1 < str.length() ? static_cast<char16_t>(str[i + 1]) : char16_t{0};
+            if (code_point <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF)
+            {
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                ++i;
+            }
+            else
+                code_point = replacement_character;
+        }
+
+        if (code_point < 0x800)
+        {
+            result.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        }
+        else if (code_point < 0x10000)
+        {
+            result.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        }
+        else
+        {
+            result.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        }
+        result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+    return result;
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <string>
+#include <string_view>
+#include "OffsetMapping.h"
+
 char *utf8_dec(const char *string, const char *current);
 char *utf8_chr(const char *s, const char *sfc);
 int utf8_symbol_len(char c);
@@ -9,3 +13,10 @@ const char* utf8_pbrk(const char* s, const char* set);
 size_t utf8_length(const char *string);
 bool utf8_is_lead(char c);
 bool utf8_is_cont(char c);
+
+// Decodes UTF-8 into UTF-16 units, characters outside of BMP become surrogate pairs and invalid bytes become U+FFFD.
+// offsets receive byte offset of the character every unit belongs to plus str.length () as the last element.
+void utf8_decode(std::string_view str, std::wstring& units, OffsetMapping& offsets);
+// Plain conversions without offsets, unpaired surrogates are encoded as U+FFFD
+std::wstring utf8_to_utf16(std::string_view str);
+std::string utf16_to_utf8(std::wstring_view str);